@@ -1,5 +1,7 @@
 #include "AssetStore.h"
 
+#include <limits>
+
 AssetStore::AssetStore()
 {
 	NPGE_INFO("AssetStore constructor called!");
@@ -13,25 +15,206 @@ AssetStore::~AssetStore()
 
 void AssetStore::ClearAssets()
 {
-	for (auto texture : textures) {
-		SDL_DestroyTexture(texture.second);
+	// Decode jobs write to the queue, let them finish before dropping what they produced
+	WaitForDecodeJobs();
+	for (const auto& decoded : decodedTextures) {
+		SDL_FreeSurface(decoded.surface);
+	}
+	decodedTextures.clear();
+	numPendingTextures = 0;
+	pendingFilePaths.clear();
+
+	// Atlas pages are shared between regions and are owned by the atlas
+	for (const auto& region : textures) {
+		if (region.texture && !region.isAtlased) {
+			SDL_DestroyTexture(region.texture);
+		}
 	}
 	textures.clear();
+	textureAtlas.Clear();
+}
+
+void AssetStore::AddTextureAtlas(SDL_Renderer* renderer, const std::string& directory, int maxPageSize)
+{
+	textureAtlas.Build(renderer, TextureAtlas::ListImages(directory), maxPageSize, threadPool);
+}
+
+TextureHandle AssetStore::AddTexture(SDL_Renderer* renderer, const std::string& assetId, const std::string& filePath)
+{
+	TextureRegion region;
+
+	if (const AtlasEntry* entry = textureAtlas.Find(filePath)) {
+		region.texture = textureAtlas.GetPage(entry->page);
+		region.rect = entry->rect;
+		region.textureWidth = textureAtlas.GetPageSize(entry->page);
+		region.textureHeight = region.textureWidth;
+		region.isAtlased = true;
+	}
+	else {
+		SDL_Surface* surface = IMG_Load(filePath.c_str());
+		if (!surface) {
+			NPGE_ERROR("Failed to load texture {0} from {1}", assetId, filePath);
+		}
+		else {
+			region.texture = SDL_CreateTextureFromSurface(renderer, surface);
+			region.rect = { 0, 0, surface->w, surface->h };
+			region.textureWidth = surface->w;
+			region.textureHeight = surface->h;
+		}
+		SDL_FreeSurface(surface);
+	}
+
+	// Resolve the asset id to its handle once, and store the texture in the handle's slot
+	const TextureHandle handle = TextureIds::Intern(assetId);
+	SetTexture(handle, region);
+
+	NPGE_DEBUG("Texture added with Asset Id : {0} Handle : {1}{2}", assetId, handle, region.isAtlased ? " (atlas)" : "");
+
+	return handle;
+}
+
+TextureHandle AssetStore::LoadTextureAsync(const std::string& assetId, const std::string& filePath)
+{
+	const TextureHandle handle = TextureIds::Intern(assetId);
+
+	// Already loading, a second decode would race the first one to the handle's slot
+	if (handle < static_cast<TextureHandle>(pendingFilePaths.size()) && !pendingFilePaths[handle].empty()) {
+		if (pendingFilePaths[handle] != filePath) {
+			NPGE_WARN("Texture {0} is already loading from {1}, ignoring {2}", assetId, pendingFilePaths[handle], filePath);
+		}
+		return handle;
+	}
+
+	// Atlas pages are already resident, nothing to decode
+	if (const AtlasEntry* entry = textureAtlas.Find(filePath)) {
+		TextureRegion region;
+		region.texture = textureAtlas.GetPage(entry->page);
+		region.rect = entry->rect;
+		region.textureWidth = textureAtlas.GetPageSize(entry->page);
+		region.textureHeight = region.textureWidth;
+		region.isAtlased = true;
+		SetTexture(handle, region);
+		return handle;
+	}
+
+	// Give the handle its slot now, it reads as empty until the upload
+	if (handle >= static_cast<TextureHandle>(textures.size())) {
+		textures.resize(handle + 1);
+	}
+	if (handle >= static_cast<TextureHandle>(pendingFilePaths.size())) {
+		pendingFilePaths.resize(handle + 1);
+	}
+	pendingFilePaths[handle] = filePath;
+	numPendingTextures++;
+
+	auto decode = [this, handle, assetId, filePath]() {
+		SDL_Surface* surface = IMG_Load(filePath.c_str());
+		if (!surface) {
+			NPGE_ERROR("Failed to load texture {0} from {1}", assetId, filePath);
+		}
+
+		std::lock_guard<std::mutex> lock(decodedTexturesMutex);
+		decodedTextures.push_back({ handle, assetId, surface });
+	};
+
+	// Decoding can take longer than a frame, it must not be picked up by a thread the frame waits on
+	if (threadPool) {
+		threadPool->SubmitBackground(decode, decodeJobs);
+	}
+	else {
+		decode();
+	}
+
+	return handle;
+}
+
+int AssetStore::UploadPendingTextures(SDL_Renderer* renderer, double budgetMs)
+{
+	std::vector<DecodedTexture> readyTextures;
+	{
+		std::lock_guard<std::mutex> lock(decodedTexturesMutex);
+		if (decodedTextures.empty()) {
+			return 0;
+		}
+		readyTextures.swap(decodedTextures);
+	}
+
+	const Uint64 startCounter = SDL_GetPerformanceCounter();
+	const double counterFrequency = static_cast<double>(SDL_GetPerformanceFrequency());
+
+	int numUploaded = 0;
+	for (const auto& decoded : readyTextures) {
+		if (numUploaded > 0 && (SDL_GetPerformanceCounter() - startCounter) * 1000.0 / counterFrequency >= budgetMs) {
+			break;
+		}
+
+		TextureRegion region;
+		if (decoded.surface) {
+			region.texture = SDL_CreateTextureFromSurface(renderer, decoded.surface);
+			region.rect = { 0, 0, decoded.surface->w, decoded.surface->h };
+			region.textureWidth = decoded.surface->w;
+			region.textureHeight = decoded.surface->h;
+			SDL_FreeSurface(decoded.surface);
+		}
+		SetTexture(decoded.handle, region);
+		pendingFilePaths[decoded.handle].clear();
+		numPendingTextures--;
+		numUploaded++;
+
+		NPGE_DEBUG("Texture uploaded with Asset Id : {0} Handle : {1}", decoded.assetId, decoded.handle);
+	}
+
+	// Out of budget, the rest waits for the next frame ahead of anything decoded meanwhile
+	if (numUploaded < static_cast<int>(readyTextures.size())) {
+		std::lock_guard<std::mutex> lock(decodedTexturesMutex);
+		decodedTextures.insert(decodedTextures.begin(), readyTextures.begin() + numUploaded, readyTextures.end());
+	}
+
+	return numUploaded;
 }
 
-void AssetStore::AddTexture(SDL_Renderer* renderer, const std::string& assetId, const std::string& filePath)
+void AssetStore::FinishPendingTextures(SDL_Renderer* renderer)
 {
-	SDL_Surface* surface = IMG_Load(filePath.c_str());
-	SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-	SDL_FreeSurface(surface);
+	WaitForDecodeJobs();
+	while (numPendingTextures > 0) {
+		UploadPendingTextures(renderer, std::numeric_limits<double>::max());
+	}
+}
+
+void AssetStore::SetTexture(TextureHandle handle, const TextureRegion& region)
+{
+	if (handle >= static_cast<TextureHandle>(textures.size())) {
+		textures.resize(handle + 1);
+	}
+	if (textures[handle].texture && !textures[handle].isAtlased) {
+		SDL_DestroyTexture(textures[handle].texture);
+	}
+	textures[handle] = region;
+}
 
-	// Add texture to map
-	textures.emplace(assetId, texture);
+void AssetStore::WaitForDecodeJobs()
+{
+	// The caller blocks on the decodes anyway, it helps with them instead of frame jobs
+	while (threadPool && !decodeJobs.IsDone()) {
+		if (!threadPool->TryRunBackgroundJob()) {
+			std::this_thread::yield();
+		}
+	}
+}
 
-	NPGE_DEBUG("Texture added with Asset Id : {0}", assetId);
+SDL_Texture* AssetStore::GetTexture(const std::string& assetId) const
+{
+	// Check if assetId exists, unknown ids do not create an entry
+	return GetTexture(TextureIds::Find(assetId));
 }
 
-SDL_Texture* AssetStore::GetTexture(const std::string& assetId) {
-	// Check if assetId exists
-	return textures[assetId];
+int AssetStore::GetNumTextures() const
+{
+	int numTextures = 0;
+	for (const auto& region : textures) {
+		if (region.texture) {
+			numTextures++;
+		}
+	}
+	return numTextures;
 }
@@ -1,28 +1,107 @@
 #ifndef ASSETSTORE_H
 #define ASSETSTORE_H
 
-#include <map>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <SDL.h>
 
 #include "../Logger/Log.h"
+#include "TextureHandle.h"
+#include "TextureAtlas.h"
+#include "../Jobs/ThreadPool.h"
 #include <SDL_image.h>
 
+/// <summary>
+/// The part of a texture an asset id refers to, either a whole standalone texture
+/// or a rectangle of an atlas page
+/// </summary>
+struct TextureRegion {
+	SDL_Texture* texture = nullptr;
+	SDL_Rect rect = { 0, 0, 0, 0 };
+	// Size of the whole texture the region lives in
+	int textureWidth = 0;
+	int textureHeight = 0;
+	bool isAtlased = false;
+};
+
 class AssetStore
 {
 private:
-	std::map<std::string, SDL_Texture*> textures;
+	// Flat texture table [index = TextureHandle], empty regions for handles without a loaded texture
+	std::vector<TextureRegion> textures;
+	TextureAtlas textureAtlas;
+
+	// Surfaces decoded on the ThreadPool, waiting to be uploaded on the render thread
+	struct DecodedTexture {
+		TextureHandle handle;
+		std::string assetId;
+		SDL_Surface* surface;
+	};
+	std::mutex decodedTexturesMutex;
+	std::vector<DecodedTexture> decodedTextures;
+	JobCounter decodeJobs;
+	// Textures requested with LoadTextureAsync and not uploaded yet
+	int numPendingTextures = 0;
+	// File each pending texture is loading from [index = TextureHandle], empty when none is
+	std::vector<std::string> pendingFilePaths;
+
+	// Decode jobs run here, not owned by the AssetStore
+	ThreadPool* threadPool = nullptr;
+
+	void SetTexture(TextureHandle handle, const TextureRegion& region);
+	void WaitForDecodeJobs();
 	// TODO: Create Map for Fonts
 	// TODO: Create Map for Audio
 public:
 	AssetStore();
 	~AssetStore();
 
+	static constexpr double DEFAULT_UPLOAD_BUDGET_MS = 2.0;
+
+	void SetThreadPool(ThreadPool* pool) { threadPool = pool; }
+
 	void ClearAssets();
-	void AddTexture(SDL_Renderer* renderer,const std::string& assetId, const std::string& filePath);
-	SDL_Texture* GetTexture(const std::string& assetId);
+
+	/// <summary>
+	/// Packs every image of the directory into atlas pages. Textures added afterwards
+	/// from one of these files point into the atlas instead of loading their own copy
+	/// </summary>
+	void AddTextureAtlas(SDL_Renderer* renderer, const std::string& directory, int maxPageSize = 2048);
+	TextureHandle AddTexture(SDL_Renderer* renderer,const std::string& assetId, const std::string& filePath);
+
+	/// <summary>
+	/// Returns the handle of assetId straight away and decodes the image on the ThreadPool.
+	/// The handle resolves to an empty region until UploadPendingTextures has uploaded it,
+	/// atlased images are resident immediately. While assetId is loading, another request
+	/// for it is not queued again and keeps the file of the first one
+	/// </summary>
+	TextureHandle LoadTextureAsync(const std::string& assetId, const std::string& filePath);
+	/// <summary>
+	/// Uploads decoded images to textures until budgetMs is spent, at least one per call.
+	/// Must run on the render thread, returns the number of textures uploaded
+	/// </summary>
+	int UploadPendingTextures(SDL_Renderer* renderer, double budgetMs = DEFAULT_UPLOAD_BUDGET_MS);
+	/// Blocks until every LoadTextureAsync texture is decoded and uploaded
+	void FinishPendingTextures(SDL_Renderer* renderer);
+	int GetNumPendingTextures() const { return numPendingTextures; }
+	bool IsTextureLoaded(TextureHandle handle) const { return GetTextureRegion(handle).texture != nullptr; }
+
+	SDL_Texture* GetTexture(const std::string& assetId) const;
+
+	/// Render path lookup, a plain index into the texture table
+	const TextureRegion& GetTextureRegion(TextureHandle handle) const {
+		static const TextureRegion emptyRegion;
+		return handle >= 0 && handle < static_cast<TextureHandle>(textures.size()) ? textures[handle] : emptyRegion;
+	}
+
+	SDL_Texture* GetTexture(TextureHandle handle) const {
+		return GetTextureRegion(handle).texture;
+	}
+
+	int GetNumTextures() const;
+	int GetNumAtlasPages() const { return textureAtlas.GetNumPages(); }
 };
 
 #endif
-
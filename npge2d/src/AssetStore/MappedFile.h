@@ -0,0 +1,37 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+/// <summary>
+/// Read only view of a whole file mapped into memory. Pages are loaded by the OS
+/// on first access, so opening costs the same whatever the size of the file
+/// </summary>
+class MappedFile
+{
+private:
+	const unsigned char* data = nullptr;
+	std::size_t size = 0;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+public:
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator =(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator =(MappedFile&& other) noexcept;
+
+	/// Maps filePath, closing the file mapped before. Returns false if it cannot be mapped
+	bool Open(const std::string& filePath);
+	void Close();
+
+	bool IsOpen() const { return data != nullptr; }
+	const unsigned char* GetData() const { return data; }
+	std::size_t GetSize() const { return size; }
+};
+
+#endif // !MAPPEDFILE_H
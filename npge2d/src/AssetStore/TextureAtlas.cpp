@@ -0,0 +1,184 @@
+#include "TextureAtlas.h"
+
+#include "../Logger/Log.h"
+
+#include <SDL_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+// imgui_draw.cpp keeps its own static copy, this one is private to the atlas as well
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <imgui/imstb_rectpack.h>
+
+TextureAtlas::~TextureAtlas()
+{
+	Clear();
+}
+
+void TextureAtlas::Clear()
+{
+	for (auto page : pages) {
+		SDL_DestroyTexture(page);
+	}
+	pages.clear();
+	pageSizes.clear();
+	entries.clear();
+}
+
+void TextureAtlas::Build(SDL_Renderer* renderer, const std::vector<std::string>& filePaths, int maxPageSize, ThreadPool* threadPool)
+{
+	struct Image {
+		std::string key;
+		SDL_Surface* surface;
+	};
+	std::vector<Image> images;
+	long long totalArea = 0;
+	int largestSide = 0;
+
+	// Decode every image to RGBA so the pages can be blitted without format surprises,
+	// images are independent so they are decoded in parallel [index = filePaths index]
+	std::vector<SDL_Surface*> surfaces(filePaths.size(), nullptr);
+	auto decodeImages = [&filePaths, &surfaces](int first, int last) {
+		for (int i = first; i < last; i++) {
+			SDL_Surface* loaded = IMG_Load(filePaths[i].c_str());
+			if (!loaded) {
+				NPGE_ERROR("Atlas failed to load {0}", filePaths[i]);
+				continue;
+			}
+			surfaces[i] = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+			SDL_FreeSurface(loaded);
+		}
+	};
+	const int numFiles = static_cast<int>(filePaths.size());
+	if (threadPool) {
+		threadPool->ParallelFor(numFiles, 1, decodeImages);
+	}
+	else {
+		decodeImages(0, numFiles);
+	}
+
+	for (std::size_t i = 0; i < filePaths.size(); i++) {
+		const std::string& filePath = filePaths[i];
+		SDL_Surface* surface = surfaces[i];
+		if (!surface) {
+			continue;
+		}
+
+		if (surface->w + PADDING > maxPageSize || surface->h + PADDING > maxPageSize) {
+			NPGE_WARN("{0} is larger than an atlas page, it is left out of the atlas", filePath);
+			SDL_FreeSurface(surface);
+			continue;
+		}
+
+		totalArea += static_cast<long long>(surface->w + PADDING) * (surface->h + PADDING);
+		largestSide = std::max({ largestSide, surface->w + PADDING, surface->h + PADDING });
+		images.push_back({ NormalizePath(filePath), surface });
+	}
+
+	std::vector<int> remaining(images.size());
+	for (int i = 0; i < static_cast<int>(images.size()); i++) {
+		remaining[i] = i;
+	}
+
+	while (!remaining.empty()) {
+		// Smallest power of two page that can hold what is left, with some slack for the packer
+		int pageSize = 64;
+		while (pageSize < maxPageSize && (pageSize < largestSide || static_cast<long long>(pageSize) * pageSize < totalArea * 5 / 4)) {
+			pageSize *= 2;
+		}
+		pageSize = std::min(pageSize, maxPageSize);
+
+		std::vector<stbrp_rect> rects(remaining.size());
+		for (std::size_t i = 0; i < remaining.size(); i++) {
+			const SDL_Surface* surface = images[remaining[i]].surface;
+			rects[i].id = remaining[i];
+			rects[i].w = static_cast<stbrp_coord>(surface->w + PADDING);
+			rects[i].h = static_cast<stbrp_coord>(surface->h + PADDING);
+		}
+
+		// Grow the page while it cannot take everything that is left
+		std::vector<stbrp_node> nodes;
+		while (true) {
+			stbrp_context context;
+			nodes.resize(pageSize);
+			stbrp_init_target(&context, pageSize, pageSize, nodes.data(), static_cast<int>(nodes.size()));
+			if (stbrp_pack_rects(&context, rects.data(), static_cast<int>(rects.size())) || pageSize >= maxPageSize) {
+				break;
+			}
+			pageSize *= 2;
+		}
+
+		SDL_Surface* pageSurface = SDL_CreateRGBSurfaceWithFormat(0, pageSize, pageSize, 32, SDL_PIXELFORMAT_RGBA32);
+		if (!pageSurface) {
+			// The pages made so far stay usable, the images left are not in the atlas
+			NPGE_ERROR("Atlas could not allocate a {0}x{0} page : {1}, {2} images are left out of the atlas", pageSize, SDL_GetError(), remaining.size());
+			for (auto index : remaining) {
+				SDL_FreeSurface(images[index].surface);
+				images[index].surface = nullptr;
+			}
+			return;
+		}
+
+		const int page = static_cast<int>(pages.size());
+		remaining.clear();
+
+		for (const auto& rect : rects) {
+			Image& image = images[rect.id];
+			if (!rect.was_packed) {
+				remaining.push_back(rect.id);
+				continue;
+			}
+
+			// Copy the pixels as they are, alpha included
+			SDL_Rect destination = { rect.x, rect.y, image.surface->w, image.surface->h };
+			SDL_SetSurfaceBlendMode(image.surface, SDL_BLENDMODE_NONE);
+			SDL_BlitSurface(image.surface, NULL, pageSurface, &destination);
+
+			entries[image.key] = { page, destination };
+			totalArea -= static_cast<long long>(rect.w) * rect.h;
+			SDL_FreeSurface(image.surface);
+			image.surface = nullptr;
+		}
+
+		SDL_Texture* pageTexture = SDL_CreateTextureFromSurface(renderer, pageSurface);
+		SDL_SetTextureBlendMode(pageTexture, SDL_BLENDMODE_BLEND);
+		SDL_FreeSurface(pageSurface);
+
+		pages.push_back(pageTexture);
+		pageSizes.push_back(pageSize);
+
+		NPGE_INFO("Atlas page {0} : {1}x{1} with {2} images left to pack", page, pageSize, remaining.size());
+	}
+}
+
+const AtlasEntry* TextureAtlas::Find(const std::string& filePath) const
+{
+	auto entry = entries.find(NormalizePath(filePath));
+	return entry != entries.end() ? &entry->second : nullptr;
+}
+
+std::string TextureAtlas::NormalizePath(const std::string& filePath)
+{
+	return std::filesystem::path(filePath).lexically_normal().generic_string();
+}
+
+std::vector<std::string> TextureAtlas::ListImages(const std::string& directory)
+{
+	std::vector<std::string> filePaths;
+	std::error_code error;
+
+	for (const auto& file : std::filesystem::directory_iterator(directory, error)) {
+		if (file.is_regular_file() && file.path().extension() == ".png") {
+			filePaths.push_back(file.path().generic_string());
+		}
+	}
+	if (error) {
+		NPGE_ERROR("Could not list images in {0}", directory);
+	}
+
+	std::sort(filePaths.begin(), filePaths.end());
+	return filePaths;
+}
@@ -0,0 +1,59 @@
+#ifndef TEXTUREATLAS_H
+#define TEXTUREATLAS_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL.h>
+
+#include "../Jobs/ThreadPool.h"
+
+/// <summary>
+/// Where an image ended up inside the atlas
+/// </summary>
+struct AtlasEntry {
+	int page;
+	SDL_Rect rect;
+};
+
+/// <summary>
+/// Packs many small images into a few large page textures at load time,
+/// so sprites using different images can be drawn from the same texture
+/// </summary>
+class TextureAtlas
+{
+private:
+	std::vector<SDL_Texture*> pages;
+	std::vector<int> pageSizes;
+	// [key = normalized file path]
+	std::unordered_map<std::string, AtlasEntry> entries;
+public:
+	static constexpr int PADDING = 1;
+
+	TextureAtlas() = default;
+	~TextureAtlas();
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas& operator =(const TextureAtlas&) = delete;
+
+	/// <summary>
+	/// Packs the images of filePaths in as few pages of at most maxPageSize as possible.
+	/// Images that do not fit a page are left out, they can still be loaded on their own.
+	/// The images are decoded on threadPool when one is given
+	/// </summary>
+	void Build(SDL_Renderer* renderer, const std::vector<std::string>& filePaths, int maxPageSize = 2048, ThreadPool* threadPool = nullptr);
+	void Clear();
+
+	/// Returns the entry of filePath or nullptr if it is not packed in the atlas
+	const AtlasEntry* Find(const std::string& filePath) const;
+
+	SDL_Texture* GetPage(int page) const { return pages[page]; }
+	int GetPageSize(int page) const { return pageSizes[page]; }
+	int GetNumPages() const { return static_cast<int>(pages.size()); }
+
+	static std::string NormalizePath(const std::string& filePath);
+	/// Lists the .png files of a directory, sorted so the packing is deterministic
+	static std::vector<std::string> ListImages(const std::string& directory);
+};
+
+#endif // !TEXTUREATLAS_H
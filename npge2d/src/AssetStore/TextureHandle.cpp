@@ -0,0 +1,48 @@
+#include "TextureHandle.h"
+
+std::mutex TextureIds::mutex;
+std::unordered_map<std::string, TextureHandle> TextureIds::handles;
+std::vector<std::string> TextureIds::names;
+
+TextureHandle TextureIds::Intern(const std::string& assetId)
+{
+	if (assetId.empty()) {
+		return INVALID_TEXTURE_HANDLE;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto handle = handles.find(assetId);
+	if (handle != handles.end()) {
+		return handle->second;
+	}
+
+	const TextureHandle newHandle = static_cast<TextureHandle>(names.size());
+	handles.emplace(assetId, newHandle);
+	names.push_back(assetId);
+	return newHandle;
+}
+
+TextureHandle TextureIds::Find(const std::string& assetId)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto handle = handles.find(assetId);
+	return handle != handles.end() ? handle->second : INVALID_TEXTURE_HANDLE;
+}
+
+std::string TextureIds::GetName(TextureHandle handle)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (handle < 0 || handle >= static_cast<TextureHandle>(names.size())) {
+		return std::string();
+	}
+	return names[handle];
+}
+
+int TextureIds::GetCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return static_cast<int>(names.size());
+}
@@ -0,0 +1,33 @@
+#ifndef TEXTUREHANDLE_H
+#define TEXTUREHANDLE_H
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Dense integer id of a texture asset, used to index the AssetStore texture table
+/// </summary>
+typedef int TextureHandle;
+const TextureHandle INVALID_TEXTURE_HANDLE = -1;
+
+/// <summary>
+/// Interns texture asset ids into TextureHandles. The same asset id always maps to the same
+/// handle, so names are resolved once at load time and never on the render path
+/// </summary>
+class TextureIds {
+private:
+	static std::mutex mutex;
+	static std::unordered_map<std::string, TextureHandle> handles;
+	static std::vector<std::string> names;
+public:
+	/// Returns the handle of assetId, creating it the first time the id is seen
+	static TextureHandle Intern(const std::string& assetId);
+	/// Returns the handle of assetId or INVALID_TEXTURE_HANDLE if it was never interned
+	static TextureHandle Find(const std::string& assetId);
+	static std::string GetName(TextureHandle handle);
+	static int GetCount();
+};
+
+#endif // !TEXTUREHANDLE_H
@@ -1,8 +0,0 @@
-#ifndef COLLIDERCOMPONENT_H
-#define COLLIDERCOMPONENT_H
-
-struct ColliderComponent {
-
-};
-
-#endif
\ No newline at end of file
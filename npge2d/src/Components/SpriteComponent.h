@@ -2,17 +2,23 @@
 #define SPRITECOMPONENT_H
 
 #include <string>
+#include <utility>
 #include <SDL.h>
 
+#include "../AssetStore/TextureHandle.h"
+
 struct SpriteComponent {
 	std::string assetId;
+	// assetId resolved once at construction, the render path only uses the handle
+	TextureHandle textureHandle;
 	int width;
 	int height;
 	int zIndex;
 	SDL_Rect srcRect;
 
 	SpriteComponent(std::string assetId = "", int width = 5, int height = 5,int zIndex = 0, int srcRectX = 0, int srcRectY = 0) {
-		this->assetId = assetId;
+		this->assetId = std::move(assetId);
+		this->textureHandle = TextureIds::Intern(this->assetId);
 		this->width = width;
 		this->height = height;
 		this->srcRect = { srcRectX, srcRectY, width, height };
@@ -0,0 +1,167 @@
+#include "PerformanceOverlay.h"
+
+#include <algorithm>
+
+#include <imgui/imgui.h>
+#include <imgui/imgui_sdl.h>
+
+#include "../Profiler/Profiler.h"
+
+void PerformanceOverlay::Initialize(SDL_Renderer* renderer, int windowWidth, int windowHeight)
+{
+	ImGui::CreateContext();
+	ImGui::GetIO().IniFilename = nullptr;
+	ImGuiSDL::Initialize(renderer, windowWidth, windowHeight);
+
+	previousCounter = SDL_GetPerformanceCounter();
+	isInitialized = true;
+}
+
+void PerformanceOverlay::Destroy()
+{
+	if (!isInitialized) {
+		return;
+	}
+
+	ImGuiSDL::Deinitialize();
+	ImGui::DestroyContext();
+	isInitialized = false;
+}
+
+void PerformanceOverlay::ProcessEvent(const SDL_Event& sdlEvent)
+{
+	if (sdlEvent.type == SDL_MOUSEWHEEL) {
+		mouseWheel += static_cast<float>(sdlEvent.wheel.y);
+	}
+}
+
+void PerformanceOverlay::Render(const Registry& registry, const AssetStore& assetStore)
+{
+	if (!isInitialized || !isVisible) {
+		return;
+	}
+
+	// Feed the input ImGui needs by hand
+	ImGuiIO& io = ImGui::GetIO();
+
+	const Uint64 counter = SDL_GetPerformanceCounter();
+	io.DeltaTime = std::max(static_cast<float>(counter - previousCounter) / SDL_GetPerformanceFrequency(), 1e-4f);
+	previousCounter = counter;
+
+	int mouseX, mouseY;
+	const Uint32 mouseButtons = SDL_GetMouseState(&mouseX, &mouseY);
+	io.MousePos = ImVec2(static_cast<float>(mouseX), static_cast<float>(mouseY));
+	io.MouseDown[0] = (mouseButtons & SDL_BUTTON_LMASK) != 0;
+	io.MouseDown[1] = (mouseButtons & SDL_BUTTON_RMASK) != 0;
+	io.MouseWheel = mouseWheel;
+	mouseWheel = 0.0f;
+
+	ImGui::NewFrame();
+
+	ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowSize(ImVec2(420, 520), ImGuiCond_FirstUseEver);
+	if (ImGui::Begin("Performance", &isVisible)) {
+		DrawFrameTimes();
+		DrawZones();
+		DrawSystems(registry);
+		DrawComponents(registry);
+		DrawAssets(assetStore);
+	}
+	ImGui::End();
+
+	ImGui::Render();
+	ImGuiSDL::Render(ImGui::GetDrawData());
+}
+
+void PerformanceOverlay::DrawFrameTimes()
+{
+	const ZoneStats frame = Profiler::GetFrameStats();
+	const std::vector<float> frameTimes = Profiler::GetFrameTimes();
+
+	ImGui::Text("Frame : %.2f ms (%.0f FPS)", frame.lastMs, frame.lastMs > 0.0 ? 1000.0 / frame.lastMs : 0.0);
+	ImGui::Text("Avg %.2f ms  Min %.2f ms  P99 %.2f ms", frame.avgMs, frame.minMs, frame.p99Ms);
+
+	// Scale the graph to the worst recent frame, never below a 60 FPS frame
+	float maxFrameTime = 1000.0f / 60.0f;
+	for (float frameTime : frameTimes) {
+		maxFrameTime = std::max(maxFrameTime, frameTime);
+	}
+	ImGui::PlotLines("##FrameTimes", frameTimes.data(), static_cast<int>(frameTimes.size()), 0,
+		nullptr, 0.0f, maxFrameTime, ImVec2(-1.0f, 60.0f));
+}
+
+void PerformanceOverlay::DrawZones()
+{
+	if (!ImGui::CollapsingHeader("Zones", ImGuiTreeNodeFlags_DefaultOpen)) {
+		return;
+	}
+
+	ImGui::Columns(4, "Zones");
+	ImGui::Text("Zone"); ImGui::NextColumn();
+	ImGui::Text("Last ms"); ImGui::NextColumn();
+	ImGui::Text("Avg ms"); ImGui::NextColumn();
+	ImGui::Text("P99 ms"); ImGui::NextColumn();
+	ImGui::Separator();
+	for (const auto& zone : Profiler::GetZoneStats()) {
+		ImGui::Text("%s", zone.name.c_str()); ImGui::NextColumn();
+		ImGui::Text("%.3f", zone.lastMs); ImGui::NextColumn();
+		ImGui::Text("%.3f", zone.avgMs); ImGui::NextColumn();
+		ImGui::Text("%.3f", zone.p99Ms); ImGui::NextColumn();
+	}
+	ImGui::Columns(1);
+}
+
+void PerformanceOverlay::DrawSystems(const Registry& registry)
+{
+	if (!ImGui::CollapsingHeader("Systems", ImGuiTreeNodeFlags_DefaultOpen)) {
+		return;
+	}
+
+	ImGui::Text("Live Entities : %d", registry.GetNumLiveEntities());
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	ImGui::Text("Archetypes : %d", registry.GetNumArchetypes());
+#endif
+
+	ImGui::Columns(2, "Systems");
+	ImGui::Text("System"); ImGui::NextColumn();
+	ImGui::Text("Entities"); ImGui::NextColumn();
+	ImGui::Separator();
+	for (const auto& system : registry.GetSystemStats()) {
+		ImGui::Text("%s", system.name.c_str()); ImGui::NextColumn();
+		ImGui::Text("%d", system.numEntities); ImGui::NextColumn();
+	}
+	ImGui::Columns(1);
+}
+
+void PerformanceOverlay::DrawComponents(const Registry& registry)
+{
+	if (!ImGui::CollapsingHeader("Components", ImGuiTreeNodeFlags_DefaultOpen)) {
+		return;
+	}
+
+	std::size_t totalMemory = 0;
+
+	ImGui::Columns(3, "Components");
+	ImGui::Text("Component"); ImGui::NextColumn();
+	ImGui::Text("Count"); ImGui::NextColumn();
+	ImGui::Text("Memory KB"); ImGui::NextColumn();
+	ImGui::Separator();
+	for (const auto& component : registry.GetComponentStats()) {
+		ImGui::Text("%s", component.name.c_str()); ImGui::NextColumn();
+		ImGui::Text("%d", component.numComponents); ImGui::NextColumn();
+		ImGui::Text("%.1f", component.memoryUsage / 1024.0); ImGui::NextColumn();
+		totalMemory += component.memoryUsage;
+	}
+	ImGui::Columns(1);
+	ImGui::Text("Total : %.1f KB", totalMemory / 1024.0);
+}
+
+void PerformanceOverlay::DrawAssets(const AssetStore& assetStore)
+{
+	if (!ImGui::CollapsingHeader("Assets", ImGuiTreeNodeFlags_DefaultOpen)) {
+		return;
+	}
+
+	ImGui::Text("Textures : %d", assetStore.GetNumTextures());
+	ImGui::Text("Atlas Pages : %d", assetStore.GetNumAtlasPages());
+}
@@ -0,0 +1,47 @@
+#ifndef PERFORMANCEOVERLAY_H
+#define PERFORMANCEOVERLAY_H
+
+#include <SDL.h>
+
+#include "../ECS/ECS.h"
+#include "../AssetStore/AssetStore.h"
+
+/// <summary>
+/// ImGui window drawn over the game with the profiler's frame graph and zone timings,
+/// the entities of every System, the storage of every component type and the loaded textures
+/// </summary>
+class PerformanceOverlay
+{
+private:
+	bool isInitialized = false;
+	bool isVisible = false;
+	Uint64 previousCounter = 0;
+	// Wheel movement received since the last frame, ImGui has no SDL platform backend here
+	float mouseWheel = 0.0f;
+
+	void DrawFrameTimes();
+	void DrawZones();
+	void DrawSystems(const Registry& registry);
+	void DrawComponents(const Registry& registry);
+	void DrawAssets(const AssetStore& assetStore);
+public:
+	PerformanceOverlay() = default;
+	PerformanceOverlay(const PerformanceOverlay&) = delete;
+	PerformanceOverlay& operator =(const PerformanceOverlay&) = delete;
+
+	/// Creates the ImGui context and its font texture on renderer
+	void Initialize(SDL_Renderer* renderer, int windowWidth, int windowHeight);
+	/// Frees the font texture, must run before the renderer is destroyed
+	void Destroy();
+
+	void Toggle() { isVisible = !isVisible; }
+	bool IsVisible() const { return isVisible; }
+
+	void ProcessEvent(const SDL_Event& sdlEvent);
+	/// <summary>
+	/// Draws the overlay on the current render target, nothing is drawn while hidden
+	/// </summary>
+	void Render(const Registry& registry, const AssetStore& assetStore);
+};
+
+#endif // !PERFORMANCEOVERLAY_H
@@ -1,4 +1,5 @@
 #include "ECS.h"
+#include "../Profiler/Profiler.h"
 
 int IComponent::nextId = 0;
 
@@ -7,25 +8,97 @@ int Entity::GetId() const
 	return id;
 }
 
+int Entity::GetGeneration() const
+{
+	return generation;
+}
+
+void Entity::Kill()
+{
+	registry->KillEntity(*this);
+}
+
+bool Entity::IsAlive() const
+{
+	return registry->IsEntityAlive(*this);
+}
+
 void System::AddEntityToSystem(Entity entity)
 {
+	const auto entityId = entity.GetId();
+
+	if (HasEntity(entity)) {
+		return;
+	}
+
+	if (entityId >= static_cast<int>(entityIdToIndex.size())) {
+		entityIdToIndex.resize(entityId + 1, -1);
+	}
+	else if (entityIdToIndex[entityId] != -1) {
+		// The slot of the id holds another generation, it leaves before the new one is added
+		RemoveEntityFromSystem(entities[entityIdToIndex[entityId]]);
+	}
+
+	entityIdToIndex[entityId] = static_cast<int>(entities.size());
 	entities.push_back(entity);
+
+#ifndef NPGE_ECS_ARCHETYPE_STORAGE
+	// The owned components follow the entity into the last slot
+	if (ownSignature.any()) {
+		registry->SwapOwnedComponentsToSlot(ownSignature, entityId, entityIdToIndex[entityId]);
+	}
+#endif
+
+	OnEntityAdded(entity);
 }
 
 void System::RemoveEntityFromSystem(Entity entity)
 {
-	/// <summary>
-	/// Lambda Function modern c++ way using iterators to remove entity from system
-	/// </summary>
-	/// <param name="entity"></param>
-	entities.erase(std::remove_if(entities.begin(), entities.end(), [&entity](Entity other) {
-		return entity == other;
-	}), entities.end());
+	if (!HasEntity(entity)) {
+		return;
+	}
+
+	// Swap the last entity into the removed slot and pop the back
+	const auto entityId = entity.GetId();
+	const int indexOfRemoved = entityIdToIndex[entityId];
+	const Entity last = entities.back();
+
+#ifndef NPGE_ECS_ARCHETYPE_STORAGE
+	// Same swap in the owned pools, the removed components end up after the System's slots
+	if (ownSignature.any()) {
+		registry->SwapOwnedComponentsToSlot(ownSignature, entityId, static_cast<int>(entities.size()) - 1);
+	}
+#endif
+
+	entities[indexOfRemoved] = last;
+	entityIdToIndex[last.GetId()] = indexOfRemoved;
+
+	entities.pop_back();
+	entityIdToIndex[entityId] = -1;
+
+	OnEntityRemoved(entity);
+}
+
+void System::RemoveEntitiesFromSystem(Span<Entity> entitiesToRemove)
+{
+	for (auto entity : entitiesToRemove) {
+		RemoveEntityFromSystem(entity);
+	}
 }
 
-std::vector<Entity> System::GetSystemEntities() const
+bool System::HasEntity(Entity entity) const
 {
-	return entities;
+	const auto entityId = entity.GetId();
+
+	if (entityId >= static_cast<int>(entityIdToIndex.size()) || entityIdToIndex[entityId] == -1) {
+		return false;
+	}
+	return entities[entityIdToIndex[entityId]] == entity;
+}
+
+Span<Entity> System::GetSystemEntities() const
+{
+	return Span<Entity>(entities);
 }
 
 const Signature& System::GetComponentSignature() const
@@ -33,37 +106,559 @@ const Signature& System::GetComponentSignature() const
 	return componentSignature;
 }
 
+const Signature& System::GetReadSignature() const
+{
+	return readSignature;
+}
+
+const Signature& System::GetWriteSignature() const
+{
+	return writeSignature;
+}
+
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+bool System::HasUnmatchedRows() const
+{
+	// Entities of the System all live in its archetypes, so when the counts agree every row is in the System
+	std::size_t numRows = 0;
+	for (auto archetype : archetypes) {
+		numRows += archetype->GetSize();
+	}
+	return numRows != entities.size();
+}
+#endif
+
+Archetype::Archetype(const Signature& signature, const ComponentInfo* componentInfos)
+	: signature(signature), componentInfos(componentInfos)
+{
+	columnOffsets.fill(0);
+	addEdges.fill(nullptr);
+	removeEdges.fill(nullptr);
+
+	std::size_t rowBytes = sizeof(Entity);
+	for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++) {
+		if (signature.test(componentId)) {
+			componentIds.push_back(componentId);
+			rowBytes += componentInfos[componentId].size;
+		}
+	}
+
+	// Fit as many rows as possible in a chunk, the entity column comes first
+	// and every component column is aligned for its type
+	auto layoutColumns = [this](int capacity) {
+		std::size_t offset = capacity * sizeof(Entity);
+		for (auto componentId : componentIds) {
+			const auto alignment = this->componentInfos[componentId].alignment;
+			offset = (offset + alignment - 1) / alignment * alignment;
+			columnOffsets[componentId] = offset;
+			offset += capacity * this->componentInfos[componentId].size;
+		}
+		return offset;
+	};
+
+	chunkCapacity = std::max(1, static_cast<int>(CHUNK_SIZE / rowBytes));
+	chunkBytes = layoutColumns(chunkCapacity);
+	while (chunkBytes > CHUNK_SIZE && chunkCapacity > 1) {
+		chunkCapacity--;
+		chunkBytes = layoutColumns(chunkCapacity);
+	}
+	chunkBytes = std::max(chunkBytes, CHUNK_SIZE);
+}
+
+Archetype::~Archetype()
+{
+	for (int row = 0; row < numRows; row++) {
+		for (auto componentId : componentIds) {
+			componentInfos[componentId].destroy(GetRowAddress(componentId, row));
+		}
+	}
+}
+
+unsigned char* Archetype::GetRowAddress(int componentId, int row) const
+{
+	const int chunkIndex = row / chunkCapacity;
+	const int chunkRow = row % chunkCapacity;
+	return chunks[chunkIndex].get() + columnOffsets[componentId] + chunkRow * componentInfos[componentId].size;
+}
+
+int Archetype::AllocateRow(Entity entity)
+{
+	const int row = numRows++;
+	const int chunkIndex = row / chunkCapacity;
+
+	// Chunks are kept once allocated and reused when the archetype grows again
+	if (chunkIndex >= static_cast<int>(chunks.size())) {
+		chunks.emplace_back(new unsigned char[chunkBytes]);
+	}
+
+	new (GetEntities(chunkIndex) + row % chunkCapacity) Entity(entity);
+	return row;
+}
+
+void Archetype::Reserve(int numRows)
+{
+	const int numChunks = (numRows + chunkCapacity - 1) / chunkCapacity;
+	chunks.reserve(numChunks);
+	while (static_cast<int>(chunks.size()) < numChunks) {
+		chunks.emplace_back(new unsigned char[chunkBytes]);
+	}
+}
+
+const Entity* Archetype::RemoveRow(int row)
+{
+	const int lastRow = numRows - 1;
+
+	for (auto componentId : componentIds) {
+		componentInfos[componentId].destroy(GetRowAddress(componentId, row));
+	}
+
+	// Move the last row into the hole to keep the table dense
+	Entity* entityAtRow = nullptr;
+	if (row != lastRow) {
+		for (auto componentId : componentIds) {
+			void* lastComponent = GetRowAddress(componentId, lastRow);
+			componentInfos[componentId].moveConstruct(GetRowAddress(componentId, row), lastComponent);
+			componentInfos[componentId].destroy(lastComponent);
+		}
+		entityAtRow = GetEntities(row / chunkCapacity) + row % chunkCapacity;
+		*entityAtRow = GetEntities(lastRow / chunkCapacity)[lastRow % chunkCapacity];
+	}
+
+	numRows--;
+	return entityAtRow;
+}
+
+void Archetype::RemoveSystem(System* system)
+{
+	systems.erase(std::remove(systems.begin(), systems.end(), system), systems.end());
+}
+
+ArchetypeStorage::EntityLocation& ArchetypeStorage::GetLocation(int entityId)
+{
+	if (entityId >= static_cast<int>(entityLocations.size())) {
+		entityLocations.resize(entityId + 1);
+	}
+	return entityLocations[entityId];
+}
+
+Archetype* ArchetypeStorage::GetOrCreateArchetype(const Signature& signature)
+{
+	auto archetype = archetypes.find(signature);
+	if (archetype != archetypes.end()) {
+		return archetype->second.get();
+	}
+
+	Archetype* newArchetype = new Archetype(signature, componentInfos.data());
+	archetypes.emplace(signature, std::unique_ptr<Archetype>(newArchetype));
+	archetypeList.push_back(newArchetype);
+
+	NPGE_DEBUG("Archetype Created : {0} ({1} rows per chunk)", signature.to_string(), newArchetype->GetChunkCapacity());
+
+	if (onArchetypeCreated) {
+		onArchetypeCreated(newArchetype);
+	}
+	return newArchetype;
+}
+
+void ArchetypeStorage::MoveEntity(Entity entity, Archetype* target)
+{
+	EntityLocation& location = GetLocation(entity.GetId());
+	Archetype* source = location.archetype;
+
+	const int targetRow = target->AllocateRow(entity);
+
+	// Move over the components both archetypes share, the source row is then destroyed
+	if (source) {
+		for (auto componentId : source->GetComponentIds()) {
+			if (target->GetSignature().test(componentId)) {
+				componentInfos[componentId].moveConstruct(target->GetComponent(componentId, targetRow), source->GetComponent(componentId, location.row));
+			}
+		}
+		RemoveRow(source, location.row);
+	}
+
+	location.archetype = target;
+	location.row = targetRow;
+}
+
+void ArchetypeStorage::RemoveRow(Archetype* archetype, int row)
+{
+	const Entity* movedEntity = archetype->RemoveRow(row);
+	if (movedEntity) {
+		entityLocations[movedEntity->GetId()].row = row;
+	}
+}
+
+void ArchetypeStorage::RemoveComponent(Entity entity, int componentId)
+{
+	EntityLocation& location = GetLocation(entity.GetId());
+	Archetype* source = location.archetype;
+
+	if (!source || !source->GetSignature().test(componentId)) {
+		return;
+	}
+
+	// Find the archetype without the component, through the cached edge when possible
+	Archetype* target = source->RemoveEdge(componentId);
+	if (!target) {
+		Signature signature = source->GetSignature();
+		signature.reset(componentId);
+
+		if (signature.none()) {
+			// No components left, the entity does not live in any archetype
+			RemoveEntity(entity);
+			return;
+		}
+
+		target = GetOrCreateArchetype(signature);
+		source->RemoveEdge(componentId) = target;
+		target->AddEdge(componentId) = source;
+	}
+
+	MoveEntity(entity, target);
+}
+
+void ArchetypeStorage::RemoveEntity(Entity entity)
+{
+	EntityLocation& location = GetLocation(entity.GetId());
+
+	if (location.archetype) {
+		RemoveRow(location.archetype, location.row);
+	}
+	location = EntityLocation();
+}
+
+Archetype* ArchetypeStorage::GetArchetype(int entityId) const
+{
+	if (entityId >= static_cast<int>(entityLocations.size())) {
+		return nullptr;
+	}
+	return entityLocations[entityId].archetype;
+}
+
+namespace {
+	// Scope of the commands the current thread records, and the ranges reserved in it so far
+	thread_local std::uint64_t currentScopeKey = 0;
+	thread_local std::uint32_t numScopeRanges = 0;
+}
+
+CommandScope::CommandScope(std::uint64_t key) : previousKey(currentScopeKey), previousNumRanges(numScopeRanges)
+{
+	currentScopeKey = key;
+	numScopeRanges = 0;
+}
+
+CommandScope::~CommandScope()
+{
+	currentScopeKey = previousKey;
+	numScopeRanges = previousNumRanges;
+}
+
+std::uint64_t CommandScope::ReserveRanges(int count)
+{
+	// Range keys follow the key of their scope, below the key of the next task
+	const std::uint64_t firstRangeKey = currentScopeKey + numScopeRanges + 1;
+	numScopeRanges += static_cast<std::uint32_t>(count);
+	return firstRangeKey;
+}
+
+std::uint64_t CommandScope::GetCurrentKey()
+{
+	return currentScopeKey;
+}
+
+CommandBuffer::~CommandBuffer()
+{
+	Clear();
+}
+
+void* CommandBuffer::Allocate(std::size_t size, std::size_t alignment)
+{
+	// Bump allocate from the current block, move on to the next block when it is full
+	while (currentBlock < blocks.size()) {
+		Block& block = blocks[currentBlock];
+		const std::size_t offset = (block.used + alignment - 1) / alignment * alignment;
+		if (offset + size <= block.size) {
+			block.used = offset + size;
+			return block.data.get() + offset;
+		}
+		currentBlock++;
+	}
+
+	const std::size_t blockSize = std::max(BLOCK_SIZE, size);
+	blocks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[blockSize]), blockSize, size });
+	currentBlock = blocks.size() - 1;
+	return blocks.back().data.get();
+}
+
+Entity CommandBuffer::Resolve(Entity entity) const
+{
+	// Placeholders have negative ids, -1 being the first entity the buffer created
+	return entity.GetId() < 0 ? createdEntities[-entity.GetId() - 1] : entity;
+}
+
+Entity CommandBuffer::CreateEntity()
+{
+	const Entity placeholder(-(++numCreatedEntities));
+	commands.push_back({ CommandType::CreateEntity, CommandScope::GetCurrentKey(), placeholder, nullptr, nullptr, nullptr });
+	return placeholder;
+}
+
+void CommandBuffer::KillEntity(Entity entity)
+{
+	commands.push_back({ CommandType::KillEntity, CommandScope::GetCurrentKey(), entity, nullptr, nullptr, nullptr });
+}
+
+void CommandBuffer::BeginPlayback()
+{
+	// Placeholders whose creation has not been played back yet resolve to an invalid entity
+	createdEntities.assign(numCreatedEntities, Entity(-1));
+}
+
+void CommandBuffer::PlaybackCommand(Registry& registry, int commandIndex)
+{
+	Command& command = commands[commandIndex];
+
+	if (command.type == CommandType::CreateEntity) {
+		createdEntities[-command.entity.GetId() - 1] = registry.CreateEntity();
+		return;
+	}
+
+	const Entity entity = Resolve(command.entity);
+	if (entity.GetId() < 0) {
+		NPGE_WARN("Command buffer entity used outside the scope that created it, command skipped");
+		return;
+	}
+
+	if (command.type == CommandType::KillEntity) {
+		registry.KillEntity(entity);
+	}
+	else {
+		command.apply(registry, entity, command.component);
+		command.component = nullptr;
+	}
+}
+
+void CommandBuffer::Playback(Registry& registry)
+{
+	BeginPlayback();
+	for (int i = 0; i < static_cast<int>(commands.size()); i++) {
+		PlaybackCommand(registry, i);
+	}
+
+	// Every recorded value was consumed by apply, skipped ones are destroyed by Clear
+	Clear();
+}
+
+void CommandBuffer::Clear()
+{
+	for (auto& command : commands) {
+		if (command.component) {
+			command.destroy(command.component);
+		}
+	}
+	commands.clear();
+	numCreatedEntities = 0;
+
+	// Keep the blocks, the next frame records into the same memory
+	for (auto& block : blocks) {
+		block.used = 0;
+	}
+	currentBlock = 0;
+}
+
+Registry::Registry()
+{
+	commandBuffers.push_back(std::make_unique<CommandBuffer>());
+
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	componentStorage.onArchetypeCreated = [this](Archetype* archetype) {
+		AddArchetypeToSystems(archetype);
+	};
+#endif
+}
+
 void Registry::Update()
 {
-	// Add the entities that are waiting to be created to the active Systems
-	for (auto entity : entitiesToBeAdded) {
-		AddEntityToSystems(entity);
+	NPGE_PROFILE_SCOPE("Registry::Update");
+
+	// Apply the structural changes Systems deferred. Buffers belong to threads, so the commands are merged
+	// by CommandScope: a scope is recorded on one thread, ties keep the buffer and record order
+	playbackOrder.clear();
+	for (int buffer = 0; buffer < static_cast<int>(commandBuffers.size()); buffer++) {
+		const auto& commands = commandBuffers[buffer]->commands;
+		for (int command = 0; command < static_cast<int>(commands.size()); command++) {
+			playbackOrder.push_back({ commands[command].scopeKey, buffer, command });
+		}
 	}
+	if (!playbackOrder.empty()) {
+		std::stable_sort(playbackOrder.begin(), playbackOrder.end(), [](const QueuedCommand& a, const QueuedCommand& b) {
+			return a.scopeKey < b.scopeKey;
+		});
+
+		for (auto& commandBuffer : commandBuffers) {
+			commandBuffer->BeginPlayback();
+		}
+		for (const auto& queued : playbackOrder) {
+			commandBuffers[queued.buffer]->PlaybackCommand(*this, queued.command);
+		}
+		for (auto& commandBuffer : commandBuffers) {
+			commandBuffer->Clear();
+		}
+	}
+
+	// Add the entities that are waiting to be created to the active Systems
+	AddEntitiesToSystems(Span<Entity>(entitiesToBeAdded));
 	entitiesToBeAdded.clear();
-	//TODO: Remove the entities that are waiting to be killed from the active Systems
+
+	// Remove the entities that are waiting to be killed from the active Systems in one batch, in id order
+	killedEntities.swap(entitiesToBeKilled);
+	entitiesToBeKilled.clear();
+	numPendingKills = 0;
+	std::sort(killedEntities.begin(), killedEntities.end());
+	RemoveEntitiesFromSystems(Span<Entity>(killedEntities));
+
+	for (auto entity : killedEntities) {
+		const auto entityId = entity.GetId();
+
+		entityComponentSignatures[entityId].reset();
+		entitiesInSystems[entityId] = false;
+		isKillPending[entityId] = false;
+
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+		// Release the row the entity had in its archetype
+		componentStorage.RemoveEntity(entity);
+#else
+		// Release the components the entity had in every pool
+		for (auto& pool : componentPools) {
+			if (pool) {
+				pool->RemoveEntityFromPool(entityId);
+			}
+		}
+#endif
+
+		// Invalidate the existing handles and make the id available for reuse
+		entityGenerations[entityId]++;
+		freeIds.push_back(entityId);
+
+		NPGE_INFO("Entity of Id : {0} Killed!", entityId);
+	}
+	killedEntities.clear();
+}
+
+void Registry::SetThreadPool(ThreadPool* pool)
+{
+	threadPool = pool;
+
+	// Buffers are made up front, creating them lazily would race between workers
+	const std::size_t numBuffers = pool ? pool->GetNumWorkers() + 1 : 1;
+	while (commandBuffers.size() < numBuffers) {
+		commandBuffers.push_back(std::make_unique<CommandBuffer>());
+	}
+}
+
+CommandBuffer& Registry::GetCommandBuffer()
+{
+	const int workerIndex = threadPool ? threadPool->GetCurrentWorkerIndex() : -1;
+	const std::size_t index = static_cast<std::size_t>(workerIndex + 1);
+	return *commandBuffers[index < commandBuffers.size() ? index : 0];
 }
 
 Entity Registry::CreateEntity()
 {
 	int entityId;
-	entityId = numEntities++;
-	Entity entity(entityId);
-	entity.registry = this;
-	entitiesToBeAdded.insert(entity);
 
-	// Make sure the entityComponentSignatures vector can accomodate the new entity
-	if(entityId >= static_cast<int>(entityComponentSignatures.size())) {
-		entityComponentSignatures.resize(entityId + 1);
+	if (freeIds.empty()) {
+		// No free ids to reuse, so grow the registry
+		entityId = numEntities++;
+
+		// Make sure the entityComponentSignatures vector can accomodate the new entity
+		if (entityId >= static_cast<int>(entityComponentSignatures.size())) {
+			entityComponentSignatures.resize(entityId + 1);
+			entityGenerations.resize(entityId + 1, 0);
+			entitiesInSystems.resize(entityId + 1, false);
+			isKillPending.resize(entityId + 1, false);
+		}
 	}
+	else {
+		// Reuse the id of a previously killed entity
+		entityId = freeIds.front();
+		freeIds.pop_front();
+	}
+
+	Entity entity(entityId, entityGenerations[entityId]);
+	entity.registry = this;
+	entitiesToBeAdded.push_back(entity);
 
-	NPGE_INFO("Entity of Id : {0} Created!", entityId);
+	NPGE_INFO("Entity of Id : {0} Generation : {1} Created!", entityId, entity.GetGeneration());
 
 	return entity;
 }
 
+void Registry::AllocateEntityIds(int count, std::vector<Entity>& entities)
+{
+	entities.reserve(entities.size() + count);
+
+	while (count > 0 && !freeIds.empty()) {
+		const int entityId = freeIds.front();
+		freeIds.pop_front();
+		entities.emplace_back(entityId, entityGenerations[entityId]);
+		count--;
+	}
+
+	// The rest are new ids, grow the per entity arrays once for all of them
+	const int firstNewId = numEntities;
+	numEntities += count;
+	if (numEntities > static_cast<int>(entityComponentSignatures.size())) {
+		entityComponentSignatures.resize(numEntities);
+		entityGenerations.resize(numEntities, 0);
+		entitiesInSystems.resize(numEntities, false);
+		isKillPending.resize(numEntities, false);
+	}
+	for (int entityId = firstNewId; entityId < numEntities; entityId++) {
+		entities.emplace_back(entityId, entityGenerations[entityId]);
+	}
+}
+
+void Registry::KillEntity(Entity entity)
+{
+	if (!IsEntityAlive(entity)) {
+		NPGE_WARN("Trying to kill stale Entity of Id : {0} Generation : {1}", entity.GetId(), entity.GetGeneration());
+		return;
+	}
+
+	// An entity killed more than once is only flushed once
+	if (isKillPending[entity.GetId()]) {
+		return;
+	}
+	isKillPending[entity.GetId()] = true;
+	numPendingKills++;
+	entitiesToBeKilled.push_back(entity);
+}
+
+bool Registry::IsEntityAlive(Entity entity) const
+{
+	const auto entityId = entity.GetId();
+
+	return entityId >= 0 && entityId < static_cast<int>(entityGenerations.size())
+		&& entityGenerations[entityId] == entity.GetGeneration();
+}
+
 void Registry::AddEntityToSystems(Entity entity)
 {
 	const auto entityId = entity.GetId();
+	entitiesInSystems[entityId] = true;
+
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	// Systems were matched once against the archetype, not against every entity
+	const Archetype* archetype = componentStorage.GetArchetype(entityId);
+	if (archetype) {
+		for (auto system : archetype->GetSystems()) {
+			system->AddEntityToSystem(entity);
+		}
+		return;
+	}
+#endif
 
 	const auto& entityComponentSignature = entityComponentSignatures[entityId];
 
@@ -76,3 +671,239 @@ void Registry::AddEntityToSystems(Entity entity)
 		}
 	}
 }
+
+void Registry::AddEntitiesToSystems(Span<Entity> entities)
+{
+	if (entities.empty()) {
+		return;
+	}
+
+	// System by System, so every System matches its Signature against the whole batch in one go
+	for (auto& system : systems) {
+		const auto& systemComponentSignature = system.second->GetComponentSignature();
+
+		for (auto entity : entities) {
+			const auto& entityComponentSignature = entityComponentSignatures[entity.GetId()];
+
+			bool isInterested = (entityComponentSignature & systemComponentSignature) == systemComponentSignature;
+			if (isInterested) {
+				system.second->AddEntityToSystem(entity);
+			}
+		}
+	}
+
+	for (auto entity : entities) {
+		entitiesInSystems[entity.GetId()] = true;
+	}
+}
+
+void Registry::AddSystemToComponents(System* system)
+{
+	const auto& systemComponentSignature = system->GetComponentSignature();
+
+#ifndef NPGE_ECS_ARCHETYPE_STORAGE
+	// Two Systems can't both order a pool, the second one iterates without owning any
+	for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++) {
+		if (system->ownSignature.test(componentId) && componentOwners[componentId]) {
+			NPGE_ERROR("Component ID : {0} is already owned by another System, the new System owns no pools", componentId);
+			system->ownSignature.reset();
+			break;
+		}
+	}
+#endif
+
+	for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++) {
+		if (systemComponentSignature.test(componentId)) {
+			componentSystems[componentId].push_back(system);
+		}
+		if (system->watchSignature.test(componentId)) {
+			componentWatchers[componentId].push_back(system);
+		}
+#ifndef NPGE_ECS_ARCHETYPE_STORAGE
+		if (system->ownSignature.test(componentId)) {
+			componentOwners[componentId] = system;
+		}
+#endif
+	}
+}
+
+void Registry::RemoveSystemFromComponents(System* system)
+{
+	for (auto& interestedSystems : componentSystems) {
+		interestedSystems.erase(std::remove(interestedSystems.begin(), interestedSystems.end(), system), interestedSystems.end());
+	}
+	for (auto& watchers : componentWatchers) {
+		watchers.erase(std::remove(watchers.begin(), watchers.end(), system), watchers.end());
+	}
+#ifndef NPGE_ECS_ARCHETYPE_STORAGE
+	for (auto& owner : componentOwners) {
+		if (owner == system) {
+			owner = nullptr;
+		}
+	}
+#endif
+}
+
+#ifndef NPGE_ECS_ARCHETYPE_STORAGE
+void Registry::SwapOwnedComponentsToSlot(const Signature& ownedComponents, int entityId, int slot)
+{
+	for (int componentId = 0; componentId < static_cast<int>(componentPools.size()); componentId++) {
+		if (ownedComponents.test(componentId)) {
+			componentPools[componentId]->SwapToSlot(entityId, slot);
+		}
+	}
+}
+#endif
+
+void Registry::AddEntityToComponentSystems(Entity entity, int componentId)
+{
+	const auto entityId = entity.GetId();
+	if (!entitiesInSystems[entityId]) {
+		return;
+	}
+
+	// Systems store the handle of the living entity, whatever handle the caller passed
+	Entity liveEntity(entityId, entityGenerations[entityId]);
+	liveEntity.registry = this;
+	const auto& entityComponentSignature = entityComponentSignatures[entityId];
+
+	// Only Systems requiring the new component can start matching
+	for (auto system : componentSystems[componentId]) {
+		const auto& systemComponentSignature = system->GetComponentSignature();
+
+		bool isInterested = (entityComponentSignature & systemComponentSignature) == systemComponentSignature;
+		if (isInterested) {
+			system->AddEntityToSystem(liveEntity);
+		}
+	}
+}
+
+void Registry::RemoveEntityFromComponentSystems(Entity entity, int componentId)
+{
+	if (!entitiesInSystems[entity.GetId()]) {
+		return;
+	}
+
+	// Every System requiring the component stops matching, the others are not affected
+	for (auto system : componentSystems[componentId]) {
+		system->RemoveEntityFromSystem(entity);
+	}
+}
+
+void Registry::NotifyComponentWatchers(Entity entity, int componentId)
+{
+	const auto entityId = entity.GetId();
+	if (!entitiesInSystems[entityId] || componentWatchers[componentId].empty()) {
+		return;
+	}
+
+	Entity liveEntity(entityId, entityGenerations[entityId]);
+	liveEntity.registry = this;
+
+	for (auto system : componentWatchers[componentId]) {
+		if (system->HasEntity(liveEntity)) {
+			system->OnEntityComponentsChanged(liveEntity);
+		}
+	}
+}
+
+void Registry::RemoveEntityFromSystems(Entity entity)
+{
+	for (auto& system : systems) {
+		system.second->RemoveEntityFromSystem(entity);
+	}
+}
+
+void Registry::RemoveEntitiesFromSystems(Span<Entity> entities)
+{
+	for (auto& system : systems) {
+		system.second->RemoveEntitiesFromSystem(entities);
+	}
+}
+
+int Registry::GetNumLiveEntities() const
+{
+	return numEntities - static_cast<int>(freeIds.size()) - numPendingKills;
+}
+
+std::vector<ComponentStats> Registry::GetComponentStats() const
+{
+	std::vector<ComponentStats> stats;
+
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	// A component is spread over every archetype containing it, its column takes the same share of each chunk
+	for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++) {
+		const ComponentInfo& info = componentStorage.GetComponentInfo(componentId);
+		if (!info.size) {
+			continue;
+		}
+
+		ComponentStats componentStats{ componentId, info.name, 0, 0 };
+		for (auto archetype : componentStorage.GetArchetypes()) {
+			if (archetype->GetSignature().test(componentId)) {
+				componentStats.numComponents += archetype->GetSize();
+				componentStats.memoryUsage += static_cast<std::size_t>(archetype->GetAllocatedChunkCount()) * archetype->GetChunkCapacity() * info.size;
+			}
+		}
+		stats.push_back(componentStats);
+	}
+#else
+	for (int componentId = 0; componentId < static_cast<int>(componentPools.size()); componentId++) {
+		const auto& pool = componentPools[componentId];
+		if (pool) {
+			stats.push_back({ componentId, pool->GetComponentName(), pool->GetSize(), pool->GetMemoryUsage() });
+		}
+	}
+#endif
+
+	return stats;
+}
+
+std::vector<SystemStats> Registry::GetSystemStats() const
+{
+	std::vector<SystemStats> stats;
+	stats.reserve(systems.size());
+
+	for (auto& system : systems) {
+		stats.push_back({ system.first.name(), static_cast<int>(system.second->GetSystemEntities().size()) });
+	}
+
+	// Map order is unspecified, keep the listing stable between frames
+	std::sort(stats.begin(), stats.end(), [](const SystemStats& a, const SystemStats& b) { return a.name < b.name; });
+	return stats;
+}
+
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+void Registry::AddArchetypeToSystems(Archetype* archetype)
+{
+	for (auto& system : systems) {
+		const auto& systemComponentSignature = system.second->GetComponentSignature();
+
+		bool isInterested = (archetype->GetSignature() & systemComponentSignature) == systemComponentSignature;
+		if (isInterested) {
+			archetype->AddSystem(system.second.get());
+			system.second->archetypes.push_back(archetype);
+		}
+	}
+}
+
+void Registry::AddSystemToArchetypes(System* system)
+{
+	const auto& systemComponentSignature = system->GetComponentSignature();
+
+	for (auto archetype : componentStorage.GetArchetypes()) {
+		bool isInterested = (archetype->GetSignature() & systemComponentSignature) == systemComponentSignature;
+		if (isInterested) {
+			archetype->AddSystem(system);
+			system->archetypes.push_back(archetype);
+		}
+	}
+}
+
+void Registry::RemoveSystemFromArchetypes(System* system)
+{
+	for (auto archetype : system->archetypes) {
+		archetype->RemoveSystem(system);
+	}
+}
+#endif
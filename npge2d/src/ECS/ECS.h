@@ -2,12 +2,25 @@
 #define ECS_H
 
 #include "../Logger/Log.h"
+#include "../Jobs/ThreadPool.h"
 
 #include <bitset>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
-#include <set>
+#include <deque>
 #include <unordered_map>
 #include <typeindex>
+#include <array>
+#include <algorithm>
+#include <memory>
+#include <functional>
+#include <typeinfo>
+#include <string>
+
+// Component storage is selected at compile time:
+// by default every component type lives in its own sparse-set Pool,
+// define NPGE_ECS_ARCHETYPE_STORAGE to store entities of the same Signature together in archetype chunks
 
 const unsigned int MAX_COMPONENTS = 32;
 /// <summary>
@@ -38,19 +51,28 @@ public:
 	}
 };
 
+/// <summary>
+/// Entity is an id into the registry plus the generation of that id.
+/// Ids are recycled once an entity is killed, the generation tells a stale handle apart
+/// from the entity that reuses its id
+/// </summary>
 class Entity {
 private:
 	int id;
+	int generation;
 public:
-	Entity(int id) : id(id) {};
+	Entity(int id, int generation = 0) : id(id), generation(generation) {};
 	Entity(const Entity& entity) = default;
 	int GetId() const;
-	// ...
+	int GetGeneration() const;
+	void Kill();
+	bool IsAlive() const;
+
 	Entity& operator =(const Entity& other) = default;
-	bool operator ==(const Entity& other) const { return id == other.id; }
-	bool operator !=(const Entity& other) const { return id != other.id; }
-	bool operator <(const Entity& other) const { return id < other.id; }
-	bool operator >(const Entity& other) const { return id > other.id; }
+	bool operator ==(const Entity& other) const { return id == other.id && generation == other.generation; }
+	bool operator !=(const Entity& other) const { return !(*this == other); }
+	bool operator <(const Entity& other) const { return id < other.id || (id == other.id && generation < other.generation); }
+	bool operator >(const Entity& other) const { return other < *this; }
 
 	template <typename T, typename ...TArgs> void AddComponent(TArgs&& ...args);
 	template <typename T> void RemoveComponent();
@@ -58,7 +80,29 @@ public:
 	template <typename T> T& GetComponent() const;
 
 	//Hold a pointer to Entitie's Owner Registry
-	class Registry* registry;
+	class Registry* registry = nullptr;
+};
+
+/// <summary>
+/// Non-owning view over a contiguous range of T, it does not copy the viewed data.
+/// The view is invalidated when the owner of the data reallocates
+/// </summary>
+/// <typeparam name="T">Element Type</typeparam>
+template <typename T>
+class Span {
+private:
+	const T* first;
+	std::size_t count;
+public:
+	Span(const T* first = nullptr, std::size_t count = 0) : first(first), count(count) {};
+	Span(const std::vector<T>& data) : first(data.data()), count(data.size()) {};
+
+	const T* begin() const { return first; }
+	const T* end() const { return first + count; }
+	std::size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	const T& operator [](std::size_t index) const { return first[index]; }
 };
 
 /// <summary>
@@ -67,21 +111,120 @@ public:
 class System {
 private:
 	Signature componentSignature;
+	// Components the System reads or writes, used to schedule Systems in parallel
+	Signature readSignature;
+	Signature writeSignature;
+	// Components whose addition or removal on an entity of the System is reported to OnEntityComponentsChanged
+	Signature watchSignature;
+	// Components whose pools are kept in the order of the entities vector
+	Signature ownSignature;
 	std::vector<Entity> entities;
+	// Slot of each entity in the entities vector, -1 if not in the System [index = entityid]
+	std::vector<int> entityIdToIndex;
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	// Archetypes whose Signature matches the System, ForEach streams through their chunks
+	std::vector<class Archetype*> archetypes;
+#endif
+protected:
+	// Owner Registry of the System, set when the System is added to the Registry
+	class Registry* registry = nullptr;
+	friend class Registry;
+
+	/// Hooks for Systems that keep their own per entity data, called after the entity list changed
+	virtual void OnEntityAdded(Entity /*entity*/) {}
+	virtual void OnEntityRemoved(Entity /*entity*/) {}
+	/// Called when an entity of the System gained or lost a watched component, after the change
+	virtual void OnEntityComponentsChanged(Entity /*entity*/) {}
 public:
 	System() = default;
-	~System() = default;
+	virtual ~System() = default;
 
 	void AddEntityToSystem(Entity entity);
 	void RemoveEntityFromSystem(Entity entity);
-	std::vector<Entity> GetSystemEntities() const;
+	void RemoveEntitiesFromSystem(Span<Entity> entitiesToRemove);
+	bool HasEntity(Entity entity) const;
+	Span<Entity> GetSystemEntities() const;
 	const Signature& GetComponentSignature() const;
+	const Signature& GetReadSignature() const;
+	const Signature& GetWriteSignature() const;
 
 	/// <summary>
-	/// Entities must have T to be considered by the System
+	/// Entities must have T to be considered by the System, required components count as read
 	/// </summary>
 	/// <typeparam name="TComponent">Component Type</typeparam>
 	template <typename TComponent> void RequireComponent();
+
+	/// <summary>
+	/// Declares that the System reads T, without requiring entities to have it
+	/// </summary>
+	/// <typeparam name="TComponent">Component Type</typeparam>
+	template <typename TComponent> void ReadsComponent();
+
+	/// <summary>
+	/// Declares that the System modifies T, the scheduler never runs it alongside a System touching T
+	/// </summary>
+	/// <typeparam name="TComponent">Component Type</typeparam>
+	template <typename TComponent> void WritesComponent();
+
+	/// <summary>
+	/// Declares that per entity data of the System depends on whether entities have T, without requiring it.
+	/// OnEntityComponentsChanged is called when an entity of the System gains or loses T
+	/// </summary>
+	/// <typeparam name="TComponent">Component Type</typeparam>
+	template <typename TComponent> void WatchesComponent();
+
+	/// <summary>
+	/// Keeps the pools of TComponents in the order of the System's entities, so ParallelForEachBatch
+	/// hands them out as arrays. A pool has one owner, it must be declared before the System gets entities.
+	/// Archetype columns are packed already, only the pool storage uses it
+	/// </summary>
+	/// <typeparam name="...TComponents">Component Types</typeparam>
+	template <typename ...TComponents> void OwnsComponents();
+
+	/// <summary>
+	/// Calls func(entity, components...) for every entity of the System.
+	/// Component pools are resolved once per call, components are handed out by reference.
+	/// With archetype storage the matching archetypes are walked chunk by chunk instead
+	/// </summary>
+	/// <typeparam name="...TComponents">Component Types passed to func</typeparam>
+	template <typename ...TComponents, typename TFunc> void ForEach(TFunc&& func);
+
+	static constexpr int DEFAULT_GRAIN_SIZE = 1024;
+	static constexpr int DEFAULT_SERIAL_THRESHOLD = 4096;
+
+	/// <summary>
+	/// Same as ForEach, but the entities are split in chunks of grainSize entities that run
+	/// on the Registry's ThreadPool. Runs serially below serialThreshold entities or without a pool.
+	/// func is called concurrently and must only touch the components it is handed
+	/// </summary>
+	/// <typeparam name="...TComponents">Component Types passed to func</typeparam>
+	template <typename ...TComponents, typename TFunc>
+	void ParallelForEach(TFunc&& func, int grainSize = DEFAULT_GRAIN_SIZE, int serialThreshold = DEFAULT_SERIAL_THRESHOLD);
+
+	/// <summary>
+	/// Calls func(entities, count, components...) for batches of consecutive entities of the System,
+	/// whose components sit side by side in memory so func can process them as arrays.
+	/// With archetype storage batches never cross a chunk, with pools the components must be owned
+	/// (OwnsComponents), otherwise every batch is a single entity. Batches are split over the ThreadPool like ParallelForEach
+	/// </summary>
+	/// <typeparam name="...TComponents">Component Types passed to func</typeparam>
+	template <typename ...TComponents, typename TFunc>
+	void ParallelForEachBatch(TFunc&& func, int grainSize = DEFAULT_GRAIN_SIZE, int serialThreshold = DEFAULT_SERIAL_THRESHOLD);
+
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+private:
+	/// Whether the entity of an archetype row is in the System, rows of entities created
+	/// since the last Registry::Update() are not matched yet
+	bool HasEntityId(int entityId) const {
+		return entityId < static_cast<int>(entityIdToIndex.size()) && entityIdToIndex[entityId] != -1;
+	}
+
+	/// Rows of the matching archetypes are only checked one by one while some of them are not in the System
+	bool HasUnmatchedRows() const;
+
+	template <typename ...TComponents, typename TFunc>
+	void ForEachBatchInChunks(const class Archetype* archetype, int firstChunk, int lastChunk, bool checkRows, TFunc& func) const;
+#endif
 };
 
 /// <summary>
@@ -90,34 +233,274 @@ public:
 class IPool {
 public:
 	virtual ~IPool() {}
+	virtual void RemoveEntityFromPool(int entityId) = 0;
+	/// Swaps the component of entityId with the one packed in slot
+	virtual void SwapToSlot(int entityId, int slot) = 0;
+
+	/// Introspection for debug tools
+	virtual int GetSize() const = 0;
+	virtual std::size_t GetMemoryUsage() const = 0;
+	virtual const char* GetComponentName() const = 0;
 };
 
 /// <summary>
-/// Pool is a vector to store T against the registry in a matrix
+/// Pool is a sparse set storing T against the entity id.
+/// Components are packed contiguously in the dense array, the sparse array maps
+/// an entity id to its slot in the dense array.
 /// </summary>
 /// <typeparam name="T">Component Type</typeparam>
 template <typename T>
 class Pool : public IPool {
 private:
+	// Packed components [index = dense slot]
 	std::vector<T> data;
+	// Owner of each packed component [index = dense slot]
+	std::vector<int> indexToEntityId;
+	// Dense slot of each entity's component, INVALID_INDEX if it has none [index = entityid]
+	std::vector<int> entityIdToIndex;
 public:
-	Pool(int size = 100) {
-		data.resize(size);
+	static constexpr int INVALID_INDEX = -1;
+
+	Pool(int capacity = 100) {
+		data.reserve(capacity);
+		indexToEntityId.reserve(capacity);
 	}
 
 	virtual ~Pool() = default;
 	bool isEmpty() const { return data.empty(); }
-	int GetSize() const { return data.size(); }
-	void Resize(int n) { data.resize(n); }
-	void Clear() { data.clear(); }
+	int GetSize() const override { return static_cast<int>(data.size()); }
+
+	std::size_t GetMemoryUsage() const override {
+		return data.capacity() * sizeof(T) + (indexToEntityId.capacity() + entityIdToIndex.capacity()) * sizeof(int);
+	}
+
+	const char* GetComponentName() const override { return typeid(T).name(); }
+
+	void Clear() {
+		data.clear();
+		indexToEntityId.clear();
+		entityIdToIndex.clear();
+	}
+
+	/// Grows the storage for numComponents components of entities with ids below numEntityIds
+	void Reserve(int numComponents, int numEntityIds) {
+		data.reserve(numComponents);
+		indexToEntityId.reserve(numComponents);
+		if (numEntityIds > static_cast<int>(entityIdToIndex.size())) {
+			entityIdToIndex.resize(numEntityIds, INVALID_INDEX);
+		}
+	}
+
+	bool Has(int entityId) const {
+		return entityId < static_cast<int>(entityIdToIndex.size()) && entityIdToIndex[entityId] != INVALID_INDEX;
+	}
+
+	/// <summary>
+	/// Constructs the component of entityId in place from args, replacing the one it already has
+	/// </summary>
+	template <typename ...TArgs>
+	T& Emplace(int entityId, TArgs&& ...args) {
+		if (Has(entityId)) {
+			// Entity already has the component, replace it in place
+			T& component = data[entityIdToIndex[entityId]];
+			component = T(std::forward<TArgs>(args)...);
+			return component;
+		}
+
+		if (entityId >= static_cast<int>(entityIdToIndex.size())) {
+			entityIdToIndex.resize(entityId + 1, INVALID_INDEX);
+		}
 
-	void Add(T object) { data.push_back(object); }
-	void Set(int index, T object) { data[index] = object; }
-	T& Get(int index) { return static_cast<T&>(data[index]); }
+		// Construct before touching the indices, args may refer to a component of this pool
+		T& component = data.emplace_back(std::forward<TArgs>(args)...);
+		entityIdToIndex[entityId] = static_cast<int>(data.size()) - 1;
+		indexToEntityId.push_back(entityId);
+		return component;
+	}
+
+	void Set(int entityId, T object) {
+		Emplace(entityId, std::move(object));
+	}
+
+	void Remove(int entityId) {
+		// Move the last packed component into the removed slot to keep the array dense
+		const int indexOfRemoved = entityIdToIndex[entityId];
+		const int indexOfLast = static_cast<int>(data.size()) - 1;
+
+		if (indexOfRemoved != indexOfLast) {
+			const int entityIdOfLast = indexToEntityId[indexOfLast];
+			data[indexOfRemoved] = std::move(data[indexOfLast]);
+			indexToEntityId[indexOfRemoved] = entityIdOfLast;
+			entityIdToIndex[entityIdOfLast] = indexOfRemoved;
+		}
+
+		data.pop_back();
+		indexToEntityId.pop_back();
+		entityIdToIndex[entityId] = INVALID_INDEX;
+	}
+
+	void RemoveEntityFromPool(int entityId) override {
+		if (Has(entityId)) {
+			Remove(entityId);
+		}
+	}
+
+	void SwapToSlot(int entityId, int slot) override {
+		const int index = entityIdToIndex[entityId];
+		if (index == slot) {
+			return;
+		}
+
+		const int entityIdInSlot = indexToEntityId[slot];
+		std::swap(data[index], data[slot]);
+		indexToEntityId[index] = entityIdInSlot;
+		indexToEntityId[slot] = entityId;
+		entityIdToIndex[entityIdInSlot] = index;
+		entityIdToIndex[entityId] = slot;
+	}
+
+	T& Get(int entityId) { return data[entityIdToIndex[entityId]]; }
+
+	/// Dense access, only live components are visited
+	T* GetData() { return data.data(); }
+	const std::vector<int>& GetEntityIds() const { return indexToEntityId; }
 	
 	T& operator [](unsigned int index) { return data[index]; }
 };
 
+/// <summary>
+/// Type erased operations the archetype storage needs to move and destroy components
+/// </summary>
+struct ComponentInfo {
+	std::size_t size = 0;
+	std::size_t alignment = 0;
+	void (*moveConstruct)(void* destination, void* source) = nullptr;
+	void (*destroy)(void* object) = nullptr;
+	const char* name = nullptr;
+
+	template <typename T> static ComponentInfo Create();
+};
+
+/// <summary>
+/// Archetype is a table of all the entities sharing the same Signature.
+/// Rows are stored in fixed size chunks, inside a chunk each component has its own column (SoA)
+/// </summary>
+class Archetype {
+private:
+	Signature signature;
+	std::vector<int> componentIds;
+	const ComponentInfo* componentInfos;
+
+	// Byte offset of each component column inside a chunk [index = componentId]
+	std::array<std::size_t, MAX_COMPONENTS> columnOffsets;
+	int chunkCapacity;
+	std::size_t chunkBytes;
+	int numRows = 0;
+	std::vector<std::unique_ptr<unsigned char[]>> chunks;
+
+	// Cached transitions to the archetype with one component more / less [index = componentId]
+	std::array<Archetype*, MAX_COMPONENTS> addEdges;
+	std::array<Archetype*, MAX_COMPONENTS> removeEdges;
+
+	// Systems interested in this archetype's Signature
+	std::vector<System*> systems;
+
+	unsigned char* GetRowAddress(int componentId, int row) const;
+public:
+	static constexpr std::size_t CHUNK_SIZE = 16 * 1024;
+
+	Archetype(const Signature& signature, const ComponentInfo* componentInfos);
+	~Archetype();
+	Archetype(const Archetype&) = delete;
+	Archetype& operator =(const Archetype&) = delete;
+
+	/// Appends a row for entity, the component slots of the row are left unconstructed
+	int AllocateRow(Entity entity);
+	/// Allocates the chunks needed to hold numRows rows
+	void Reserve(int numRows);
+	/// Destroys the row and moves the last row in its place, returns the moved entity or nullptr
+	const Entity* RemoveRow(int row);
+
+	void* GetComponent(int componentId, int row) const { return GetRowAddress(componentId, row); }
+	Entity* GetEntities(int chunkIndex) const { return reinterpret_cast<Entity*>(chunks[chunkIndex].get()); }
+	template <typename T> T* GetColumn(int chunkIndex) const;
+
+	int GetSize() const { return numRows; }
+	int GetChunkCount() const { return (numRows + chunkCapacity - 1) / chunkCapacity; }
+	int GetChunkSize(int chunkIndex) const { return std::min(chunkCapacity, numRows - chunkIndex * chunkCapacity); }
+	int GetChunkCapacity() const { return chunkCapacity; }
+	int GetAllocatedChunkCount() const { return static_cast<int>(chunks.size()); }
+	std::size_t GetMemoryUsage() const { return chunks.size() * chunkBytes; }
+	const Signature& GetSignature() const { return signature; }
+	const std::vector<int>& GetComponentIds() const { return componentIds; }
+
+	Archetype*& AddEdge(int componentId) { return addEdges[componentId]; }
+	Archetype*& RemoveEdge(int componentId) { return removeEdges[componentId]; }
+
+	void AddSystem(System* system) { systems.push_back(system); }
+	void RemoveSystem(System* system);
+	const std::vector<System*>& GetSystems() const { return systems; }
+};
+
+/// <summary>
+/// Owns every archetype and remembers in which archetype row each entity lives
+/// </summary>
+class ArchetypeStorage {
+private:
+	struct EntityLocation {
+		Archetype* archetype = nullptr;
+		int row = -1;
+	};
+
+	std::array<ComponentInfo, MAX_COMPONENTS> componentInfos;
+	std::unordered_map<Signature, std::unique_ptr<Archetype>> archetypes;
+	std::vector<Archetype*> archetypeList;
+
+	// [vector index = entityid]
+	std::vector<EntityLocation> entityLocations;
+
+	EntityLocation& GetLocation(int entityId);
+	Archetype* GetOrCreateArchetype(const Signature& signature);
+	void MoveEntity(Entity entity, Archetype* target);
+	void RemoveRow(Archetype* archetype, int row);
+public:
+	// Called every time a new archetype is created, so that Systems can be matched against it
+	std::function<void(Archetype*)> onArchetypeCreated;
+
+	ArchetypeStorage() = default;
+	ArchetypeStorage(const ArchetypeStorage&) = delete;
+	ArchetypeStorage& operator =(const ArchetypeStorage&) = delete;
+
+	template <typename T, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
+	/// Places entities without components straight in the archetype of TComponents, each with a copy of components
+	template <typename ...TComponents> void AddEntities(Span<Entity> entities, const TComponents& ...components);
+	void RemoveComponent(Entity entity, int componentId);
+	void RemoveEntity(Entity entity);
+	template <typename T> T& Get(int entityId) const;
+
+	Archetype* GetArchetype(int entityId) const;
+	const std::vector<Archetype*>& GetArchetypes() const { return archetypeList; }
+	const ComponentInfo& GetComponentInfo(int componentId) const { return componentInfos[componentId]; }
+};
+
+/// <summary>
+/// Storage used by one component type, reported by Registry::GetComponentStats()
+/// </summary>
+struct ComponentStats {
+	int componentId;
+	std::string name;
+	int numComponents;
+	std::size_t memoryUsage;
+};
+
+/// <summary>
+/// Number of entities matched by one System, reported by Registry::GetSystemStats()
+/// </summary>
+struct SystemStats {
+	std::string name;
+	int numEntities;
+};
+
 /// <summary>
 /// Manages the creation and destruction of entities, as well as
 /// adding systems and components to entities
@@ -126,10 +509,34 @@ class Registry {
 private:
 	int numEntities = 0;
 
+	/// Takes count ids, reusing freed ids first, and sizes the per entity arrays once
+	void AllocateEntityIds(int count, std::vector<Entity>& entities);
+
+	// Current generation of every entity id, bumped each time the id is freed
+	// [vector index = entityid]
+	std::vector<int> entityGenerations;
+
+	// Ids of killed entities that are free to be reused by CreateEntity()
+	std::deque<int> freeIds;
+
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	// Archetype tables, entities with the same Signature are stored together
+	ArchetypeStorage componentStorage;
+#else
+	template <typename T> Pool<T>* GetOrCreateComponentPool();
+
 	// Vector of component pools, each pool contains all the data for a certain component
-	// [vector index = componentId], [pool index = entityid]
+	// [vector index = componentId], [pool sparse index = entityid]
 	std::vector<std::shared_ptr<IPool>> componentPools;
 
+	// System keeping each pool in the order of its entities, if any [array index = componentId]
+	std::array<System*, MAX_COMPONENTS> componentOwners = {};
+
+	/// Moves the owned components of entityId into slot of their pools, System keeps its pools in step with its entities
+	void SwapOwnedComponentsToSlot(const Signature& ownedComponents, int entityId, int slot);
+	friend class System;
+#endif
+
 	// Vector of component signatures, determines which components are turned 'on' for an entity
 	// [vector index = entityid]
 	std::vector<Signature> entityComponentSignatures;
@@ -137,27 +544,100 @@ private:
 	// Map of active systems [index = system typeid]
 	std::unordered_map<std::type_index, std::shared_ptr<System>> systems;
 
+	// Systems requiring each component, the only ones to re-match when an entity gains or loses it
+	// [array index = componentId]
+	std::array<std::vector<System*>, MAX_COMPONENTS> componentSystems;
+	// Systems watching each component [array index = componentId]
+	std::array<std::vector<System*>, MAX_COMPONENTS> componentWatchers;
+
+	// Whether the entity already went through AddEntitiesToSystems, pending entities are matched
+	// on the next Update() instead [vector index = entityid]
+	std::vector<bool> entitiesInSystems;
+
 	// Set of entities that are flagged to be addred or removed in the next registry Update()
-	std::set<Entity> entitiesToBeAdded;
-	std::set<Entity> entitiesToBeKilled;
+	// Flat lists, an id appears once in each of them
+	std::vector<Entity> entitiesToBeAdded;
+	std::vector<Entity> entitiesToBeKilled;
+
+	// Whether the entity is in entitiesToBeKilled [vector index = entityid]
+	std::vector<bool> isKillPending;
+	int numPendingKills = 0;
+
+	// Scratch list used to flush entitiesToBeKilled in one batch, keeps its capacity between updates
+	std::vector<Entity> killedEntities;
+
+	// Deferred structural changes, one buffer per thread that can run Systems
+	// [index 0 = threads outside the pool, index i + 1 = pool worker i]
+	std::vector<std::unique_ptr<class CommandBuffer>> commandBuffers;
+
+	// Commands of every buffer merged into playback order, keeps its capacity between updates
+	struct QueuedCommand {
+		std::uint64_t scopeKey;
+		int buffer;
+		int command;
+	};
+	std::vector<QueuedCommand> playbackOrder;
+
+	// Shared job pool Systems split their work on, not owned by the Registry
+	ThreadPool* threadPool = nullptr;
+
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	void AddArchetypeToSystems(Archetype* archetype);
+	void AddSystemToArchetypes(System* system);
+	void RemoveSystemFromArchetypes(System* system);
+#endif
+	void AddSystemToComponents(System* system);
+	void RemoveSystemFromComponents(System* system);
+
+	/// Re-match the entity against the Systems requiring componentId, after it gained or lost it
+	void AddEntityToComponentSystems(Entity entity, int componentId);
+	void RemoveEntityFromComponentSystems(Entity entity, int componentId);
+	/// Tells the Systems watching componentId that the entity gained or lost it
+	void NotifyComponentWatchers(Entity entity, int componentId);
 public:
-	Registry() = default;
+	Registry();
+	Registry(const Registry&) = delete;
+	Registry& operator =(const Registry&) = delete;
 
 	void Update();
 	/// Managing Entities, Systems and Components
 
+	/// Also sizes the per thread command buffers, must not be called while Systems are running
+	void SetThreadPool(ThreadPool* pool);
+	ThreadPool* GetThreadPool() const { return threadPool; }
+
+	/// <summary>
+	/// Command buffer of the calling thread, played back at the start of the next Update().
+	/// Each thread owns its buffer, so Systems running on the pool record without locking.
+	/// The buffers are merged by CommandScope on playback, which worker ran a job does not matter
+	/// </summary>
+	CommandBuffer& GetCommandBuffer();
+
 	/*
 	* Entity Management
 	*/
 	Entity CreateEntity();
+	/// <summary>
+	/// Creates count entities that each get a copy of components. Storage is reserved once for the
+	/// whole batch, the entities join the Systems in one pass on the next Update()
+	/// </summary>
+	/// <typeparam name="...TComponents">Component Types given to every entity</typeparam>
+	template <typename ...TComponents> std::vector<Entity> CreateEntities(int count, const TComponents& ...components);
+	void KillEntity(Entity entity);
+	bool IsEntityAlive(Entity entity) const;
 
 	/*
 	* Component Management
+	* Adding or removing a component of an entity already in the Systems re-matches it right away,
+	* changes made while a System iterates its entities go through the CommandBuffer instead
 	*/
 	template <typename T, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
 	template <typename T> void RemoveComponent(Entity entity);
 	template <typename T> bool HasComponent(Entity entity) const;
 	template <typename T> T& GetComponent(Entity entity) const;
+#ifndef NPGE_ECS_ARCHETYPE_STORAGE
+	template <typename T> Pool<T>* GetComponentPool() const;
+#endif
 
 	/*
 	* System Management
@@ -168,6 +648,108 @@ public:
 	template <typename T> T& GetSystem() const;
 
 	void AddEntityToSystems(Entity entity);
+	void AddEntitiesToSystems(Span<Entity> entities);
+	void RemoveEntityFromSystems(Entity entity);
+	void RemoveEntitiesFromSystems(Span<Entity> entities);
+
+	/*
+	* Introspection, meant for debug tools and not for per frame game logic
+	*/
+	/// Entities created and not killed, entities killed since the last Update() no longer count
+	int GetNumLiveEntities() const;
+	std::vector<ComponentStats> GetComponentStats() const;
+	std::vector<SystemStats> GetSystemStats() const;
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	int GetNumArchetypes() const { return static_cast<int>(componentStorage.GetArchetypes().size()); }
+#endif
+};
+
+/// <summary>
+/// Orders the commands recorded on the calling thread while it is open. The scheduler opens one
+/// per task and parallel loops one per range, playback sorts the commands of every buffer by scope
+/// so their order does not depend on which worker ran which job. Commands recorded outside any
+/// scope come first, then the tasks in the order they were added, each followed by its ranges.
+/// Ranges do not nest, a parallel loop started inside a range is not ordered
+/// </summary>
+class CommandScope {
+private:
+	std::uint64_t previousKey;
+	std::uint32_t previousNumRanges;
+public:
+	explicit CommandScope(std::uint64_t key);
+	~CommandScope();
+	CommandScope(const CommandScope&) = delete;
+	CommandScope& operator =(const CommandScope&) = delete;
+
+	static std::uint64_t GetTaskKey(int taskIndex) { return static_cast<std::uint64_t>(taskIndex + 1) << 32; }
+	/// Reserves count ranges in the current scope, range i of them has the key returned + i
+	static std::uint64_t ReserveRanges(int count);
+	/// Key of the commands recorded now on the calling thread
+	static std::uint64_t GetCurrentKey();
+};
+
+/// <summary>
+/// Records structural changes to apply to the Registry later: entity creation and kills,
+/// component additions and removals. Commands are played back in the order they were recorded,
+/// component values wait in an append only arena whose blocks are reused between playbacks
+/// </summary>
+class CommandBuffer {
+private:
+	enum class CommandType { CreateEntity, KillEntity, AddComponent, RemoveComponent };
+
+	struct Command {
+		CommandType type;
+		// CommandScope the command was recorded in
+		std::uint64_t scopeKey;
+		Entity entity;
+		// Component commands, apply also destroys the recorded value
+		void (*apply)(Registry& registry, Entity entity, void* component);
+		void (*destroy)(void* component);
+		void* component;
+	};
+
+	struct Block {
+		std::unique_ptr<unsigned char[]> data;
+		std::size_t size;
+		std::size_t used;
+	};
+
+	std::vector<Command> commands;
+	std::vector<Block> blocks;
+	std::size_t currentBlock = 0;
+	int numCreatedEntities = 0;
+	// Entities made by playback for the placeholders [index = placeholder index]
+	std::vector<Entity> createdEntities;
+
+	void* Allocate(std::size_t size, std::size_t alignment);
+	Entity Resolve(Entity entity) const;
+
+	// Registry::Update interleaves the commands of its buffers
+	void BeginPlayback();
+	void PlaybackCommand(Registry& registry, int commandIndex);
+	friend class Registry;
+public:
+	static constexpr std::size_t BLOCK_SIZE = 16 * 1024;
+
+	CommandBuffer() = default;
+	~CommandBuffer();
+	CommandBuffer(const CommandBuffer&) = delete;
+	CommandBuffer& operator =(const CommandBuffer&) = delete;
+
+	/// <summary>
+	/// Returns a placeholder for the entity created on playback. The placeholder is only
+	/// meant to be passed to the other commands of this buffer recorded in the same CommandScope
+	/// </summary>
+	Entity CreateEntity();
+	void KillEntity(Entity entity);
+	template <typename T, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
+	template <typename T> void RemoveComponent(Entity entity);
+
+	/// Applies the recorded commands to registry in the order they were recorded and empties the buffer
+	void Playback(Registry& registry);
+	/// Drops the recorded commands without applying them
+	void Clear();
+	bool IsEmpty() const { return commands.empty(); }
 };
 
 
@@ -176,52 +758,365 @@ void System::RequireComponent()
 {
 	const auto componentId = Component<TComponent>::GetId();
 	componentSignature.set(componentId);
+	readSignature.set(componentId);
+}
+
+template<typename TComponent>
+void System::ReadsComponent()
+{
+	const auto componentId = Component<TComponent>::GetId();
+	readSignature.set(componentId);
+}
+
+template<typename TComponent>
+void System::WritesComponent()
+{
+	const auto componentId = Component<TComponent>::GetId();
+	writeSignature.set(componentId);
+}
+
+template<typename TComponent>
+void System::WatchesComponent()
+{
+	const auto componentId = Component<TComponent>::GetId();
+	watchSignature.set(componentId);
+}
+
+template<typename ...TComponents>
+void System::OwnsComponents()
+{
+	(ownSignature.set(Component<TComponents>::GetId()), ...);
+}
+
+template<typename ...TComponents, typename TFunc>
+void System::ForEach(TFunc&& func)
+{
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	// Stream through the columns of every matching archetype, one chunk at a time
+	auto forEachEntity = [&func](const Entity* batchEntities, int count, TComponents* ...components) {
+		for (int i = 0; i < count; i++) {
+			func(batchEntities[i], components[i]...);
+		}
+	};
+	const bool checkRows = HasUnmatchedRows();
+	for (auto archetype : archetypes) {
+		ForEachBatchInChunks<TComponents...>(archetype, 0, archetype->GetChunkCount(), checkRows, forEachEntity);
+	}
+#else
+	if (entities.empty()) {
+		return;
+	}
+
+	// Resolve the pools once, every entity of the System has all the required components
+	auto forEachEntity = [this, &func](Pool<TComponents>* ...componentPools) {
+		for (auto entity : entities) {
+			func(entity, componentPools->Get(entity.GetId())...);
+		}
+	};
+	forEachEntity(registry->GetComponentPool<TComponents>()...);
+#endif
+}
+
+template<typename ...TComponents, typename TFunc>
+void System::ParallelForEach(TFunc&& func, int grainSize, int serialThreshold)
+{
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	ParallelForEachBatch<TComponents...>([&func](const Entity* batchEntities, int count, TComponents* ...components) {
+		for (int i = 0; i < count; i++) {
+			func(batchEntities[i], components[i]...);
+		}
+	}, grainSize, serialThreshold);
+#else
+	ThreadPool* threadPool = registry->GetThreadPool();
+	grainSize = std::max(1, grainSize);
+	const int numEntities = static_cast<int>(entities.size());
+
+	if (!threadPool || numEntities < serialThreshold) {
+		ForEach<TComponents...>(func);
+		return;
+	}
+
+	// Each range records its commands in its own scope, they play back in entity order
+	const std::uint64_t firstRangeKey = CommandScope::ReserveRanges((numEntities + grainSize - 1) / grainSize);
+	auto parallelForEachEntity = [this, &func, threadPool, numEntities, grainSize, firstRangeKey](Pool<TComponents>* ...componentPools) {
+		threadPool->ParallelFor(numEntities, grainSize, [this, &func, grainSize, firstRangeKey, componentPools...](int first, int last) {
+			const CommandScope commandScope(firstRangeKey + first / grainSize);
+			for (int i = first; i < last; i++) {
+				const Entity entity = entities[i];
+				func(entity, componentPools->Get(entity.GetId())...);
+			}
+		});
+	};
+	parallelForEachEntity(registry->GetComponentPool<TComponents>()...);
+#endif
+}
+
+template<typename ...TComponents, typename TFunc>
+void System::ParallelForEachBatch(TFunc&& func, int grainSize, int serialThreshold)
+{
+	ThreadPool* threadPool = registry->GetThreadPool();
+	grainSize = std::max(1, grainSize);
+
+#ifndef NPGE_ECS_ARCHETYPE_STORAGE
+	const int numEntities = static_cast<int>(entities.size());
+	if (numEntities == 0) {
+		return;
+	}
+
+	// Slot i of an owned pool holds the component of entities[i], a range of the entity list is a range
+	// of every owned pool. Components of pools the System does not own are looked up one by one
+	const bool isOwned = (ownSignature.test(Component<TComponents>::GetId()) && ...);
+	auto forEachBatch = [this, &func, isOwned](int first, int last, Pool<TComponents>* ...componentPools) {
+		if (isOwned) {
+			func(entities.data() + first, last - first, (componentPools->GetData() + first)...);
+			return;
+		}
+		for (int i = first; i < last; i++) {
+			func(&entities[i], 1, &componentPools->Get(entities[i].GetId())...);
+		}
+	};
+	auto parallelForEachBatch = [&forEachBatch, threadPool, numEntities, grainSize, serialThreshold](Pool<TComponents>* ...componentPools) {
+		if (!threadPool || numEntities < serialThreshold) {
+			forEachBatch(0, numEntities, componentPools...);
+			return;
+		}
+
+		// Each range records its commands in its own scope, they play back in entity order
+		const std::uint64_t firstRangeKey = CommandScope::ReserveRanges((numEntities + grainSize - 1) / grainSize);
+		threadPool->ParallelFor(numEntities, grainSize, [&forEachBatch, grainSize, firstRangeKey, componentPools...](int first, int last) {
+			const CommandScope commandScope(firstRangeKey + first / grainSize);
+			forEachBatch(first, last, componentPools...);
+		});
+	};
+	parallelForEachBatch(registry->GetComponentPool<TComponents>()...);
+#else
+	const bool checkRows = HasUnmatchedRows();
+
+	// Archetype chunks are already cache sized, a job takes as many whole chunks as fit the grain
+	for (auto archetype : archetypes) {
+		const int numChunks = archetype->GetChunkCount();
+
+		if (!threadPool || archetype->GetSize() < serialThreshold) {
+			ForEachBatchInChunks<TComponents...>(archetype, 0, numChunks, checkRows, func);
+			continue;
+		}
+
+		const int chunksPerJob = std::max(1, grainSize / archetype->GetChunkCapacity());
+		const std::uint64_t firstRangeKey = CommandScope::ReserveRanges((numChunks + chunksPerJob - 1) / chunksPerJob);
+		threadPool->ParallelFor(numChunks, chunksPerJob, [this, archetype, checkRows, chunksPerJob, firstRangeKey, &func](int firstChunk, int lastChunk) {
+			const CommandScope commandScope(firstRangeKey + firstChunk / chunksPerJob);
+			ForEachBatchInChunks<TComponents...>(archetype, firstChunk, lastChunk, checkRows, func);
+		});
+	}
+#endif
+}
+
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+
+template<typename ...TComponents, typename TFunc>
+void System::ForEachBatchInChunks(const Archetype* archetype, int firstChunk, int lastChunk, bool checkRows, TFunc& func) const
+{
+	for (int chunkIndex = firstChunk; chunkIndex < lastChunk; chunkIndex++) {
+		const int chunkSize = archetype->GetChunkSize(chunkIndex);
+		const Entity* chunkEntities = archetype->GetEntities(chunkIndex);
+
+		// Skip the rows not in the System, so both storages visit the same entities.
+		// Once every entity is matched a batch is the whole chunk
+		auto forEachBatch = [this, chunkSize, chunkEntities, checkRows, &func](TComponents* ...columns) {
+			if (!checkRows) {
+				func(chunkEntities, chunkSize, columns...);
+				return;
+			}
+
+			int row = 0;
+			while (row < chunkSize) {
+				if (!HasEntityId(chunkEntities[row].GetId())) {
+					row++;
+					continue;
+				}
+
+				const int firstRow = row;
+				while (row < chunkSize && HasEntityId(chunkEntities[row].GetId())) {
+					row++;
+				}
+				func(chunkEntities + firstRow, row - firstRow, (columns + firstRow)...);
+			}
+		};
+		forEachBatch(archetype->template GetColumn<TComponents>(chunkIndex)...);
+	}
+}
+#endif
+
+template<typename T>
+ComponentInfo ComponentInfo::Create()
+{
+	static_assert(alignof(T) <= alignof(std::max_align_t), "Over aligned components are not supported by the archetype storage");
+
+	ComponentInfo info;
+	info.size = sizeof(T);
+	info.alignment = alignof(T);
+	info.name = typeid(T).name();
+	info.moveConstruct = [](void* destination, void* source) {
+		new (destination) T(std::move(*static_cast<T*>(source)));
+	};
+	info.destroy = [](void* object) {
+		static_cast<T*>(object)->~T();
+	};
+	return info;
+}
+
+template<typename T>
+T* Archetype::GetColumn(int chunkIndex) const
+{
+	return reinterpret_cast<T*>(chunks[chunkIndex].get() + columnOffsets[Component<T>::GetId()]);
 }
 
 template<typename T, typename ...TArgs>
-void Registry::AddComponent(Entity entity, TArgs && ...args)
+void ArchetypeStorage::AddComponent(Entity entity, TArgs && ...args)
 {
 	const auto componentId = Component<T>::GetId();
 	const auto entityId = entity.GetId();
 
-	// If componentId > current size of ComponentPools, resize the vector
-	if (componentId >= static_cast<int>(componentPools.size())) {
-		componentPools.resize(componentId + 1, nullptr);
+	if (!componentInfos[componentId].size) {
+		componentInfos[componentId] = ComponentInfo::Create<T>();
 	}
 
-	// If we still dont have a Pool for that component type
-	if (!componentPools[componentId]) {
-		std::shared_ptr<Pool<T>> newComponentPool = std::make_shared<Pool<T>>();
-		componentPools[componentId] = newComponentPool;
+	// Create the component first, args may refer to components that are about to be moved
+	T newComponent(std::forward<TArgs>(args)...);
+
+	EntityLocation& location = GetLocation(entityId);
+	Archetype* source = location.archetype;
+
+	// Entity already has the component, replace it in place
+	if (source && source->GetSignature().test(componentId)) {
+		*static_cast<T*>(source->GetComponent(componentId, location.row)) = std::move(newComponent);
+		return;
 	}
 
-	// Get the pool of component values for that component type
-	std::shared_ptr<Pool<T>> componentPool = std::static_pointer_cast<Pool<T>>(componentPools[componentId]);
+	// Find the archetype with the extra component, through the cached edge when possible
+	Archetype* target = source ? source->AddEdge(componentId) : nullptr;
+	if (!target) {
+		Signature signature = source ? source->GetSignature() : Signature();
+		signature.set(componentId);
+		target = GetOrCreateArchetype(signature);
 
-	// If the entity id > current size of component pool, resize the pool
-	if (entityId >= static_cast<int>(componentPool->GetSize())) {
-		componentPool->Resize(numEntities);
+		if (source) {
+			source->AddEdge(componentId) = target;
+			target->RemoveEdge(componentId) = source;
+		}
 	}
 
-	// Create a new component of T type and forward the various params to the constructor
-	T newComponent(std::forward<TArgs>(args)...);
+	MoveEntity(entity, target);
+	new (target->GetComponent(componentId, location.row)) T(std::move(newComponent));
+}
 
-	// Add the new component to component pool list
-	componentPool->Set(entityId, newComponent);
+template<typename ...TComponents>
+void ArchetypeStorage::AddEntities(Span<Entity> entities, const TComponents& ...components)
+{
+	if (entities.empty()) {
+		return;
+	}
+
+	Signature signature;
+	auto registerComponent = [this, &signature](int componentId, ComponentInfo info) {
+		if (!componentInfos[componentId].size) {
+			componentInfos[componentId] = info;
+		}
+		signature.set(componentId);
+	};
+	(registerComponent(Component<TComponents>::GetId(), ComponentInfo::Create<TComponents>()), ...);
+
+	if (signature.none()) {
+		return;
+	}
+
+	int maxEntityId = 0;
+	for (auto entity : entities) {
+		maxEntityId = std::max(maxEntityId, entity.GetId());
+	}
+	if (maxEntityId >= static_cast<int>(entityLocations.size())) {
+		entityLocations.resize(maxEntityId + 1);
+	}
+
+	Archetype* target = GetOrCreateArchetype(signature);
+	target->Reserve(target->GetSize() + static_cast<int>(entities.size()));
+
+	for (auto entity : entities) {
+		const int row = target->AllocateRow(entity);
+		(new (target->GetComponent(Component<TComponents>::GetId(), row)) TComponents(components), ...);
+		entityLocations[entity.GetId()] = { target, row };
+	}
+}
+
+template<typename T>
+T& ArchetypeStorage::Get(int entityId) const
+{
+	const EntityLocation& location = entityLocations[entityId];
+	return *static_cast<T*>(location.archetype->GetComponent(Component<T>::GetId(), location.row));
+}
+
+template<typename T, typename ...TArgs>
+void Registry::AddComponent(Entity entity, TArgs && ...args)
+{
+	const auto componentId = Component<T>::GetId();
+	const auto entityId = entity.GetId();
+
+	// A stale handle may point at a reused id, the components belong to the entity living there now
+	if (!IsEntityAlive(entity)) {
+		NPGE_WARN("Trying to add Component ID : {0} to stale Entity of Id : {1} Generation : {2}", componentId, entityId, entity.GetGeneration());
+		return;
+	}
+	const bool hadComponent = entityComponentSignatures[entityId].test(componentId);
+
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	// Move the entity to the archetype that also has T
+	entity.registry = this;
+	componentStorage.AddComponent<T>(entity, std::forward<TArgs>(args)...);
+#else
+	// Construct the component straight in the pool, the pool grows its sparse array on demand
+	GetOrCreateComponentPool<T>()->Emplace(entityId, std::forward<TArgs>(args)...);
+#endif
 
 	entityComponentSignatures[entityId].set(componentId);
 
+	// Replacing a component does not change which Systems the entity belongs to
+	if (!hadComponent) {
+		AddEntityToComponentSystems(entity, componentId);
+		NotifyComponentWatchers(entity, componentId);
+	}
+
 	NPGE_DEBUG("Component ID : {0} Added to Entity ID : {1}", componentId, entityId);
 }
 
 template<typename T>
 void Registry::RemoveComponent(Entity entity)
 {
-	// Assuming Already exists
 	const auto componentId = Component<T>::GetId();
 	const auto entityId = entity.GetId();
 
+	if (!IsEntityAlive(entity)) {
+		NPGE_WARN("Trying to remove Component ID : {0} from stale Entity of Id : {1} Generation : {2}", componentId, entityId, entity.GetGeneration());
+		return;
+	}
+
+	// Nothing to remove, the pool has no slot for the entity
+	if (!entityComponentSignatures[entityId].test(componentId)) {
+		return;
+	}
+
+	// Leave the Systems first, their removal hooks may still read the component
+	RemoveEntityFromComponentSystems(entity, componentId);
+
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	// Move the entity to the archetype without T
+	componentStorage.RemoveComponent(entity, componentId);
+#else
+	// Remove the component from the pool, the last component is swapped into its slot
+	GetComponentPool<T>()->Remove(entityId);
+#endif
+
 	entityComponentSignatures[entityId].set(componentId, false);
+	NotifyComponentWatchers(entity, componentId);
 
 	NPGE_DEBUG("Component ID : {0} Removed From Entity ID : {1}", componentId, entityId);
 }
@@ -238,23 +1133,99 @@ bool Registry::HasComponent(Entity entity) const
 template<typename T>
 T& Registry::GetComponent(Entity entity) const
 {
-	const auto componentId = Component<T>::GetId();
 	const auto entityId = entity.GetId();
-	auto componentPool = std::static_pointer_cast<Pool<T>>(componentPools[componentId]);
-	return componentPool->Get(entityId);
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	return componentStorage.Get<T>(entityId);
+#else
+	// Raw pool pointer, copying the shared_ptr would contend on its refcount across worker threads
+	return GetComponentPool<T>()->Get(entityId);
+#endif
 }
 
+template<typename ...TComponents>
+std::vector<Entity> Registry::CreateEntities(int count, const TComponents& ...components)
+{
+	std::vector<Entity> entities;
+	if (count <= 0) {
+		return entities;
+	}
+	AllocateEntityIds(count, entities);
+
+	Signature signature;
+	(signature.set(Component<TComponents>::GetId()), ...);
+
+	for (auto& entity : entities) {
+		entity.registry = this;
+		entityComponentSignatures[entity.GetId()] = signature;
+	}
+
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	componentStorage.AddEntities(Span<Entity>(entities), components...);
+#else
+	// Grow every pool once, then append the components back to back
+	auto addComponents = [&entities, &components..., this](Pool<TComponents>* ...componentPools) {
+		(componentPools->Reserve(componentPools->GetSize() + static_cast<int>(entities.size()), numEntities), ...);
+		for (auto entity : entities) {
+			(componentPools->Emplace(entity.GetId(), components), ...);
+		}
+	};
+	addComponents(GetOrCreateComponentPool<TComponents>()...);
+#endif
+
+	entitiesToBeAdded.insert(entitiesToBeAdded.end(), entities.begin(), entities.end());
+
+	NPGE_INFO("{0} Entities Created with Signature : {1}", count, signature.to_string());
+
+	return entities;
+}
+
+#ifndef NPGE_ECS_ARCHETYPE_STORAGE
+template<typename T>
+Pool<T>* Registry::GetOrCreateComponentPool()
+{
+	const auto componentId = Component<T>::GetId();
+
+	if (componentId >= static_cast<int>(componentPools.size())) {
+		componentPools.resize(componentId + 1, nullptr);
+	}
+	if (!componentPools[componentId]) {
+		componentPools[componentId] = std::make_shared<Pool<T>>();
+	}
+	return static_cast<Pool<T>*>(componentPools[componentId].get());
+}
+
+template<typename T>
+Pool<T>* Registry::GetComponentPool() const
+{
+	const auto componentId = Component<T>::GetId();
+
+	if (componentId >= static_cast<int>(componentPools.size())) {
+		return nullptr;
+	}
+	return static_cast<Pool<T>*>(componentPools[componentId].get());
+}
+#endif
+
 template<typename T, typename ...TArgs>
 void Registry::AddSystem(TArgs && ...args)
 {
 	std::shared_ptr<T> newSystem = std::make_shared<T>(std::forward<TArgs>(args)...);
+	newSystem->registry = this;
 	systems.insert(std::make_pair(std::type_index(typeid(T)), newSystem));
+	AddSystemToComponents(newSystem.get());
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	AddSystemToArchetypes(newSystem.get());
+#endif
 }
 
 template<typename T>
 void Registry::RemoveSystem()
 {
 	auto system = systems.find(std::type_index(typeid(T)));
+	RemoveSystemFromComponents(system->second.get());
+#ifdef NPGE_ECS_ARCHETYPE_STORAGE
+	RemoveSystemFromArchetypes(system->second.get());
+#endif
 	systems.erase(system);
 }
 
@@ -268,7 +1239,39 @@ template<typename T>
 T& Registry::GetSystem() const
 {
 	auto system = systems.find(std::type_index(typeid(T)));
-	return *(std::static_pointer_cast<T>(system->second));
+	return *static_cast<T*>(system->second.get());
+}
+
+template<typename T, typename ...TArgs>
+void CommandBuffer::AddComponent(Entity entity, TArgs && ...args)
+{
+	static_assert(alignof(T) <= alignof(std::max_align_t), "Over aligned components are not supported by the command buffer");
+
+	Command command{ CommandType::AddComponent, CommandScope::GetCurrentKey(), entity, nullptr, nullptr, nullptr };
+	command.component = new (Allocate(sizeof(T), alignof(T))) T(std::forward<TArgs>(args)...);
+	command.apply = [](Registry& registry, Entity entity, void* component) {
+		T* value = static_cast<T*>(component);
+		if (registry.IsEntityAlive(entity)) {
+			registry.AddComponent<T>(entity, std::move(*value));
+		}
+		value->~T();
+	};
+	command.destroy = [](void* component) {
+		static_cast<T*>(component)->~T();
+	};
+	commands.push_back(command);
+}
+
+template<typename T>
+void CommandBuffer::RemoveComponent(Entity entity)
+{
+	Command command{ CommandType::RemoveComponent, CommandScope::GetCurrentKey(), entity, nullptr, nullptr, nullptr };
+	command.apply = [](Registry& registry, Entity entity, void*) {
+		if (registry.IsEntityAlive(entity) && registry.HasComponent<T>(entity)) {
+			registry.RemoveComponent<T>(entity);
+		}
+	};
+	commands.push_back(command);
 }
 
 template<typename T, typename ...TArgs>
@@ -3,15 +3,18 @@
 #include <fstream>
 
 #include "../Logger/Log.h"
+#include "../Profiler/Profiler.h"
 
 #include "../Systems/MovementSystem.h"
 #include "../Systems/RenderSystem.h"
 #include "../Systems/AnimationSystem.h"
+#include "../Systems/CollisionSystem.h"
 
 #include "../Components/TransformComponent.h"
 #include "../Components/RigidBodyComponent.h"
 #include "../Components/SpriteComponent.h"
 #include "../Components/AnimationComponent.h"
+#include "../Components/BoxColliderComponent.h"
 
 
 Game::Game()
@@ -21,6 +24,10 @@ Game::Game()
 
 	registry = std::make_unique<Registry>();
 	assetStore = std::make_unique<AssetStore>();
+	threadPool = std::make_unique<ThreadPool>();
+	registry->SetThreadPool(threadPool.get());
+	assetStore->SetThreadPool(threadPool.get());
+	updateScheduler = std::make_unique<SystemScheduler>(*threadPool);
 
 	NPGE_INFO("NegProt\'s Game Engine 2D");
 }
@@ -66,6 +73,11 @@ void Game::Initialize()
 		return;
 	}
 
+	// The camera covers the whole window
+	camera = Camera(glm::vec2(0, 0), 1.0f, windowWidth, windowHeight);
+
+	performanceOverlay.Initialize(renderer, windowWidth, windowHeight);
+
 	// Create real fullscreen - Change Videomode
 	// TURN ON REAL FULL SCREEN
 	//SDL_SetWindowFullscreen(window, SDL_WINDOW_FULLSCREEN);
@@ -73,22 +85,102 @@ void Game::Initialize()
 	isRunning = true;
 }
 
+void Game::InitializeHeadless()
+{
+	if (SDL_Init(SDL_INIT_TIMER) != 0) {
+		NPGE_CRITICAL("Error Initializing SDL Timer");
+		return;
+	}
+
+	// Levels still place entities relative to the window
+	windowWidth = 800;
+	windowHeight = 600;
+	camera = Camera(glm::vec2(0, 0), 1.0f, windowWidth, windowHeight);
+
+	isHeadless = true;
+	isRunning = true;
+}
+
 void Game::Run()
 {
 	NPGE_INFO("NegProt's Game Engine 2D");
 	NPGE_INFO("FPS Capped At : {0}", FPS);
+	NPGE_INFO("Simulation Tick Rate : {0}", TICK_RATE);
 	Setup();
+
+	const double counterFrequency = static_cast<double>(SDL_GetPerformanceFrequency());
+	Uint64 previousCounter = SDL_GetPerformanceCounter();
+
 	while (isRunning) {
+		const Uint64 frameStartCounter = SDL_GetPerformanceCounter();
+		accumulator += (frameStartCounter - previousCounter) / counterFrequency;
+		previousCounter = frameStartCounter;
+
 		ProcessInput();
+
+		// Run as many fixed ticks as the elapsed time holds, the remainder carries over to the next frame
+		int numFrameTicks = static_cast<int>(accumulator / FIXED_DELTA_TIME);
+		if (numFrameTicks > MAX_TICKS_PER_FRAME) {
+			NPGE_WARN("Simulation is {0} ticks behind, dropping the time past {1} ticks", numFrameTicks, MAX_TICKS_PER_FRAME);
+			numFrameTicks = MAX_TICKS_PER_FRAME;
+			accumulator = MAX_TICKS_PER_FRAME * FIXED_DELTA_TIME;
+		}
+		for (int tick = 0; tick < numFrameTicks; tick++) {
+			// The frame is drawn between the state before the last tick and after it
+			if (tick == numFrameTicks - 1) {
+				registry->GetSystem<RenderSystem>().SaveTransforms();
+			}
+			Update();
+			accumulator -= FIXED_DELTA_TIME;
+		}
+
+		// Textures still decoding are uploaded a few at a time, their sprites appear once resident
+		if (assetStore->GetNumPendingTextures() > 0) {
+			NPGE_PROFILE_SCOPE("AssetStore::UploadPendingTextures");
+			assetStore->UploadPendingTextures(renderer);
+		}
+
+		Render(accumulator / FIXED_DELTA_TIME);
+		NPGE_PROFILE_FRAME();
+
+		// Rendering is still capped, there is nothing new to draw faster than the display can show
+		const double frameTime = (SDL_GetPerformanceCounter() - frameStartCounter) / counterFrequency;
+		const int timeToWait = MILLISECS_PER_FRAME - static_cast<int>(frameTime * 1000.0);
+		if (timeToWait > 0 && timeToWait <= MILLISECS_PER_FRAME) {
+			SDL_Delay(timeToWait);
+		}
+	}
+}
+
+double Game::RunHeadless(int numTicks)
+{
+	NPGE_INFO("NegProt's Game Engine 2D");
+	NPGE_INFO("Headless Run : {0} ticks", numTicks);
+	Setup();
+
+	const Uint64 startCounter = SDL_GetPerformanceCounter();
+	for (int tick = 0; tick < numTicks && isRunning; tick++) {
 		Update();
-		Render();
+		NPGE_PROFILE_FRAME();
 	}
+	const double elapsedTime = (SDL_GetPerformanceCounter() - startCounter) / static_cast<double>(SDL_GetPerformanceFrequency());
+
+	const double ticksPerSecond = elapsedTime > 0.0 ? numTicks / elapsedTime : 0.0;
+	NPGE_INFO("Headless Run : {0} ticks in {1:.3f} s, {2:.1f} ticks per second", numTicks, elapsedTime, ticksPerSecond);
+#ifndef NPGE_CONFIG_RELEASE
+	for (const auto& zone : Profiler::GetZoneStats()) {
+		NPGE_INFO("{0} : min {1:.3f} ms, avg {2:.3f} ms, p99 {3:.3f} ms", zone.name, zone.minMs, zone.avgMs, zone.p99Ms);
+	}
+#endif
+	return ticksPerSecond;
 }
 
 void Game::ProcessInput()
 {
+	NPGE_PROFILE_SCOPE("Game::ProcessInput");
 	SDL_Event sdlEvent;
 	while (SDL_PollEvent(&sdlEvent)) {
+		performanceOverlay.ProcessEvent(sdlEvent);
 		switch (sdlEvent.type)
 		{
 		case SDL_QUIT:
@@ -98,6 +190,26 @@ void Game::ProcessInput()
 			if (sdlEvent.key.keysym.sym == SDLK_ESCAPE) {
 				isRunning = false;
 			}
+			if (sdlEvent.key.keysym.sym == SDLK_F1) {
+				performanceOverlay.Toggle();
+			}
+			// Dump the last recorded zone timings for chrome://tracing
+			if (sdlEvent.key.keysym.sym == SDLK_F2) {
+				if (Profiler::WriteChromeTrace(PROFILE_TRACE_PATH)) {
+					NPGE_INFO("Profile trace written to {0}", PROFILE_TRACE_PATH);
+				}
+				else {
+					NPGE_ERROR("Could not write profile trace to {0}", PROFILE_TRACE_PATH);
+				}
+			}
+			break;
+		case SDL_RENDER_TARGETS_RESET:
+		case SDL_RENDER_DEVICE_RESET:
+			// Baked tilemap chunks are lost with the render targets
+			if (tilemap) {
+				tilemap->InvalidateChunks();
+			}
+			break;
 		}
 	}
 }
@@ -105,42 +217,47 @@ void Game::ProcessInput()
 void Game::LoadLevel(int level) {
 	// Add Systems that need to be processed in our game
 	registry->AddSystem<MovementSystem>();
-	registry->AddSystem<RenderSystem>();
+	if (!isHeadless) {
+		registry->AddSystem<RenderSystem>();
+	}
 	registry->AddSystem<AnimationSystem>();
+	registry->AddSystem<CollisionSystem>();
+
+	// Movement writes Transform and Animation writes Sprite, so they update side by side
+	updateScheduler->AddTask(registry->GetSystem<MovementSystem>(), [this]() {
+		registry->GetSystem<MovementSystem>().Update(FIXED_DELTA_TIME);
+	});
+	updateScheduler->AddTask(registry->GetSystem<AnimationSystem>(), [this]() {
+		registry->GetSystem<AnimationSystem>().Update();
+	});
+	// Reads Transform, so it runs once Movement is done
+	updateScheduler->AddTask(registry->GetSystem<CollisionSystem>(), [this]() {
+		registry->GetSystem<CollisionSystem>().Update();
+	});
+
+	// Adding ass3ets to asset store, there is nothing to draw them with when headless
+	if (!isHeadless) {
+		// Pack the sprite images first so the textures below resolve to atlas regions
+		assetStore->AddTextureAtlas(renderer, "./assets/images");
+		// The rest decode on the thread pool while the level starts, Run() uploads them as they are ready
+		assetStore->LoadTextureAsync("tank-image", "./assets/images/tank-panther-right.png");
+		assetStore->LoadTextureAsync("truck-image", "./assets/images/truck-ford-right.png");
+		assetStore->LoadTextureAsync("helicopter-sprite", "./assets/images/chopper.png");
+		assetStore->LoadTextureAsync("radar-sprite", "./assets/images/radar.png");
+		assetStore->LoadTextureAsync("tilemap-texture", "./assets/tilemaps/jungle.png");
+	}
 
-	// Adding ass3ets to asset store
-	assetStore->AddTexture(renderer, "tank-image", "./assets/images/tank-panther-right.png");
-	assetStore->AddTexture(renderer, "truck-image", "./assets/images/truck-ford-right.png");
-	assetStore->AddTexture(renderer, "helicopter-sprite", "./assets/images/chopper.png");
-	assetStore->AddTexture(renderer, "radar-sprite", "./assets/images/radar.png");
-	assetStore->AddTexture(renderer, "tilemap-texture", "./assets/tilemaps/jungle.png");
-
-	// Load the tilemap
-	int tileSize = 32;
+	// Load the tilemap from its binary file, mapped and used in place.
+	// The text map is the fallback, the jungle tileset is 10 tiles wide
 	double tileScale = 1.0;
-	int mapNumCols = 25;
-	int mapNumRows = 20;
-	// Load map file
-	std::fstream mapFile;
-	std::string STRING;
-	mapFile.open("./assets/tilemaps/jungle.map");
-	for (int y = 0; y < mapNumRows; y++)
-	{
-		for (int x = 0; x < mapNumCols; x++)
-		{
-			char ch;
-			mapFile.get(ch);
-			int srcRectY = std::atoi(&ch) * tileSize;
-			mapFile.get(ch);
-			int srcRectX = std::atoi(&ch) * tileSize;
-			mapFile.ignore();
-			// One entity per tile
-			Entity tile = registry->CreateEntity();
-			tile.AddComponent<TransformComponent>(glm::vec2(x * (tileScale * tileSize), y * (tileScale * tileSize)), glm::vec2(tileScale, tileScale), 0.0);
-			tile.AddComponent<SpriteComponent>("tilemap-texture", tileSize, tileSize, 0, srcRectX, srcRectY);
-		}
+	tilemap = Tilemap::LoadFromBinaryFile("./assets/tilemaps/jungle.tmb", tileScale, TextureIds::Find("tilemap-texture"));
+	if (!tilemap) {
+		int tileSize = 32;
+		int mapNumCols = 25;
+		int mapNumRows = 20;
+		tilemap = std::make_unique<Tilemap>(mapNumCols, mapNumRows, tileSize, tileScale, TextureIds::Find("tilemap-texture"));
+		tilemap->LoadFromTextFile("./assets/tilemaps/jungle.map", 10);
 	}
-	mapFile.close();
 
 	// Create Entity
 	// Add some components to that entity
@@ -149,11 +266,13 @@ void Game::LoadLevel(int level) {
 	tank.AddComponent<TransformComponent>(glm::vec2(50, 100), glm::vec2(2, 2), 0.0);
 	tank.AddComponent<RigidBodyComponent>(glm::vec2(30, 0));
 	tank.AddComponent<SpriteComponent>("tank-image", 32, 32, 1);
+	tank.AddComponent<BoxColliderComponent>(32, 32);
 	
 	Entity truck = registry->CreateEntity();
 	truck.AddComponent<TransformComponent>(glm::vec2(70, 100), glm::vec2(2, 2), 0.0);
 	truck.AddComponent<RigidBodyComponent>(glm::vec2(45, 0));
 	truck.AddComponent<SpriteComponent>("truck-image", 32, 32, 1);
+	truck.AddComponent<BoxColliderComponent>(32, 32);
 	
 	Entity helicopter = registry->CreateEntity();
 	helicopter.AddComponent<TransformComponent>(glm::vec2(100, 100), glm::vec2(2, 2), 0.0);
@@ -174,41 +293,41 @@ void Game::Setup() {
 
 void Game::Update()
 {
-	// If too fast, waste time till we reach MILLISECS_PER_FRAME
-	// By This if there is no need to Limit FPS in game
-	//while (!SDL_TICKS_PASSED(SDL_GetTicks(), millisecsPreviousFrame + MILLISECS_PER_FRAME));
-	int timeToWait = MILLISECS_PER_FRAME - (SDL_GetTicks() - millisecsPreviousFrame);
-	if (timeToWait > 0 && timeToWait <= MILLISECS_PER_FRAME) {
-		SDL_Delay(timeToWait);
-	}
+	NPGE_PROFILE_SCOPE("Game::Update");
 
-	// Difference in ticsk since last frame in secs.
-	double deltaTime = (SDL_GetTicks() - millisecsPreviousFrame) / 1000.0;
-
-	//Store current frame time
-	millisecsPreviousFrame = SDL_GetTicks();
-
-	// Invoke all the systems that need to update
-	registry->GetSystem<MovementSystem>().Update(deltaTime);
-	// Update Collision System
+	// Invoke all the systems that need to update, collision included
+	updateScheduler->Run();
 	// Update Damage System
 
 	// Update the registry to process the entities that are waiting to be creating/removed
 	registry->Update();
+	numTicks++;
 }
 
-void Game::Render()
+void Game::Render(double interpolation)
 {
 	SDL_SetRenderDrawColor(renderer, 21, 21, 21, 0);
 	SDL_RenderClear(renderer);
 	
+	// Render the static tilemap layer under the game objects
+	{
+		NPGE_PROFILE_SCOPE("Tilemap::Render");
+		tilemap->Render(renderer, assetStore, camera);
+	}
+
 	// Render Game Objects
 
 	// Invoke all the systems that need to render
-	registry->GetSystem<RenderSystem>().Update(renderer, assetStore);
-	registry->GetSystem<AnimationSystem>().Update();
+	registry->GetSystem<RenderSystem>().Update(renderer, assetStore, camera, interpolation);
+
+	// Debug overlay on top of everything
+	if (performanceOverlay.IsVisible()) {
+		NPGE_PROFILE_SCOPE("PerformanceOverlay::Render");
+		performanceOverlay.Render(*registry, *assetStore);
+	}
 	
 	// Back and Front Buffer Swap
+	NPGE_PROFILE_SCOPE("SDL_RenderPresent");
 	SDL_RenderPresent(renderer);
 }
 
@@ -216,7 +335,15 @@ void Game::Destroy()
 {
 	// LOG MANAGER DESTROY (Here or in Destructor)
 
-	SDL_DestroyRenderer(renderer);
-	SDL_DestroyWindow(window);
+	// Chunk textures and loaded textures belong to the renderer
+	tilemap.reset();
+	assetStore->ClearAssets();
+	performanceOverlay.Destroy();
+	if (renderer) {
+		SDL_DestroyRenderer(renderer);
+	}
+	if (window) {
+		SDL_DestroyWindow(window);
+	}
 	SDL_Quit();
 }
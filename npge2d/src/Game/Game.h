@@ -8,33 +8,67 @@
 #include "../Logger/Logger.h"
 #include "../ECS/ECS.h"
 #include "../AssetStore/AssetStore.h"
+#include "../Jobs/ThreadPool.h"
+#include "../Jobs/SystemScheduler.h"
+#include "../Tilemap/Tilemap.h"
+#include "../Renderer/Camera.h"
+#include "../Debug/PerformanceOverlay.h"
 
 const int FPS = 120;
 const int MILLISECS_PER_FRAME = 1000 / FPS;
 
+// Simulation ticks per second, every tick advances the game by exactly FIXED_DELTA_TIME
+const int TICK_RATE = 120;
+const double FIXED_DELTA_TIME = 1.0 / TICK_RATE;
+// Spiral of death clamp, a late frame runs at most this many ticks and drops the time left over
+const int MAX_TICKS_PER_FRAME = 8;
+
+// Where F2 writes the profiler's Chrome trace
+const std::string PROFILE_TRACE_PATH = "./profile.json";
+
 class Game
 {
 private:
 	bool isRunning;
-	int millisecsPreviousFrame = 0;
+	// No window, renderer or textures, the simulation ticks as fast as it can
+	bool isHeadless = false;
+	// Simulation time not consumed by ticks yet, in seconds
+	double accumulator = 0.0;
+	Uint64 numTicks = 0;
 	Logger logManager;
-	SDL_Window* window;
-	SDL_Renderer* renderer;
+	SDL_Window* window = nullptr;
+	SDL_Renderer* renderer = nullptr;
 
 	std::unique_ptr<Registry> registry;
 	std::unique_ptr<AssetStore> assetStore;
+	std::unique_ptr<ThreadPool> threadPool;
+	std::unique_ptr<Tilemap> tilemap;
+	Camera camera;
+	// Toggled with F1
+	PerformanceOverlay performanceOverlay;
+
+	// Simulation systems, updated in parallel when their component access does not conflict
+	std::unique_ptr<SystemScheduler> updateScheduler;
 
 public:
 	Game();
 	~Game();
 
 	void Initialize();
+	/// Initializes only SDL's timer, for running the simulation without a display
+	void InitializeHeadless();
 	void Run();
+	/// <summary>
+	/// Runs numTicks simulation ticks back to back without input or rendering, returns the ticks per second reached
+	/// </summary>
+	double RunHeadless(int numTicks);
 	void ProcessInput();
 	void LoadLevel(int level);
 	void Setup();
+	/// Advances the simulation by one tick of FIXED_DELTA_TIME
 	void Update();
-	void Render();
+	/// interpolation in [0, 1] is how far the frame is between the previous tick and the last one
+	void Render(double interpolation);
 	void Destroy();
 
 	int windowWidth;
@@ -0,0 +1,123 @@
+#include "SystemScheduler.h"
+
+#include <thread>
+
+SystemScheduler::SystemScheduler(ThreadPool& threadPool) : threadPool(threadPool)
+{
+}
+
+void SystemScheduler::AddTask(const System& system, std::function<void()> update, bool isMainThreadOnly)
+{
+	Task task;
+	task.system = &system;
+	task.update = std::move(update);
+	task.isMainThreadOnly = isMainThreadOnly;
+	tasks.push_back(std::move(task));
+
+	isDirty = true;
+}
+
+void SystemScheduler::Clear()
+{
+	tasks.clear();
+	isDirty = true;
+}
+
+bool SystemScheduler::IsConflicting(const System& a, const System& b)
+{
+	const auto aReads = a.GetReadSignature() | a.GetComponentSignature();
+	const auto bReads = b.GetReadSignature() | b.GetComponentSignature();
+
+	return (a.GetWriteSignature() & (bReads | b.GetWriteSignature())).any()
+		|| (b.GetWriteSignature() & aReads).any();
+}
+
+void SystemScheduler::Build()
+{
+	// Dependency graph, an edge goes from an earlier task to every later task it conflicts with
+	for (auto& task : tasks) {
+		task.dependents.clear();
+		task.numDependencies = 0;
+	}
+
+	for (int i = 0; i < static_cast<int>(tasks.size()); i++) {
+		for (int j = i + 1; j < static_cast<int>(tasks.size()); j++) {
+			if (IsConflicting(*tasks[i].system, *tasks[j].system)) {
+				tasks[i].dependents.push_back(j);
+				tasks[j].numDependencies++;
+			}
+		}
+	}
+
+	remainingDependencies = std::make_unique<std::atomic<int>[]>(tasks.size());
+	isDirty = false;
+}
+
+void SystemScheduler::Run()
+{
+	if (isDirty) {
+		Build();
+	}
+
+	const int numTasks = static_cast<int>(tasks.size());
+	numFinishedTasks = 0;
+	for (int i = 0; i < numTasks; i++) {
+		remainingDependencies[i] = tasks[i].numDependencies;
+	}
+
+	for (int i = 0; i < numTasks; i++) {
+		if (tasks[i].numDependencies == 0) {
+			Dispatch(i);
+		}
+	}
+
+	// Run the main thread tasks here and help the pool with the rest until everything finished
+	while (numFinishedTasks.load(std::memory_order_acquire) < numTasks) {
+		int mainThreadTask = -1;
+		{
+			std::lock_guard<std::mutex> lock(mainThreadMutex);
+			if (!mainThreadTasks.empty()) {
+				mainThreadTask = mainThreadTasks.back();
+				mainThreadTasks.pop_back();
+			}
+		}
+
+		if (mainThreadTask >= 0) {
+			RunTask(mainThreadTask);
+		}
+		else if (!threadPool.TryRunPendingJob()) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void SystemScheduler::Dispatch(int taskIndex)
+{
+	if (tasks[taskIndex].isMainThreadOnly) {
+		std::lock_guard<std::mutex> lock(mainThreadMutex);
+		mainThreadTasks.push_back(taskIndex);
+		return;
+	}
+
+	threadPool.Submit([this, taskIndex]() {
+		RunTask(taskIndex);
+	});
+}
+
+void SystemScheduler::RunTask(int taskIndex)
+{
+	{
+		// Commands the task records play back in task order, whichever thread ran it
+		const CommandScope commandScope(CommandScope::GetTaskKey(taskIndex));
+		tasks[taskIndex].update();
+	}
+
+	// Release the tasks that were waiting on this one
+	for (auto dependent : tasks[taskIndex].dependents) {
+		if (remainingDependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			Dispatch(dependent);
+		}
+	}
+
+	numFinishedTasks.fetch_add(1, std::memory_order_release);
+}
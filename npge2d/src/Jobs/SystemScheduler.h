@@ -0,0 +1,61 @@
+#ifndef SYSTEMSCHEDULER_H
+#define SYSTEMSCHEDULER_H
+
+#include "../ECS/ECS.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/// <summary>
+/// Runs system updates in parallel on a ThreadPool.
+/// Tasks are ordered by the order they were added in, a task waits for every earlier task
+/// whose component access conflicts with its own (write/write or read/write on the same component)
+/// </summary>
+class SystemScheduler {
+private:
+	struct Task {
+		const System* system;
+		std::function<void()> update;
+		bool isMainThreadOnly;
+		std::vector<int> dependents;
+		int numDependencies = 0;
+	};
+
+	ThreadPool& threadPool;
+	std::vector<Task> tasks;
+
+	// Remaining dependencies of each task during Run() [index = task index]
+	std::unique_ptr<std::atomic<int>[]> remainingDependencies;
+	std::atomic<int> numFinishedTasks{ 0 };
+
+	// Tasks that became ready but must run on the thread calling Run()
+	std::mutex mainThreadMutex;
+	std::vector<int> mainThreadTasks;
+
+	bool isDirty = false;
+
+	void Build();
+	void Dispatch(int taskIndex);
+	void RunTask(int taskIndex);
+public:
+	SystemScheduler(ThreadPool& threadPool);
+	~SystemScheduler() = default;
+
+	/// <summary>
+	/// Adds the update of system to the schedule.
+	/// Main thread only tasks (rendering, input) always run on the thread calling Run()
+	/// </summary>
+	void AddTask(const System& system, std::function<void()> update, bool isMainThreadOnly = false);
+	void Clear();
+
+	/// Runs every task once and returns when all of them finished
+	void Run();
+
+	static bool IsConflicting(const System& a, const System& b);
+};
+
+#endif // !SYSTEMSCHEDULER_H
@@ -0,0 +1,206 @@
+#include "ThreadPool.h"
+
+#include "../Logger/Log.h"
+
+#include <algorithm>
+
+namespace {
+	// Pool the current thread works for and the queue it owns there, the index is only
+	// meaningful for that pool [nullptr / -1 on threads that are not workers of a pool]
+	thread_local const ThreadPool* currentPool = nullptr;
+	thread_local int currentWorkerIndex = -1;
+}
+
+ThreadPool::ThreadPool(unsigned int numWorkers)
+{
+	if (numWorkers == 0) {
+		const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		numWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	for (unsigned int i = 0; i < numWorkers; i++) {
+		queues.push_back(std::make_unique<WorkQueue>());
+	}
+	for (unsigned int i = 0; i < numWorkers; i++) {
+		workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+
+	NPGE_INFO("ThreadPool started with {0} workers", numWorkers);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		isRunning = false;
+	}
+	wakeUp.notify_all();
+
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+int ThreadPool::GetCurrentWorkerIndex() const
+{
+	return currentPool == this ? currentWorkerIndex : -1;
+}
+
+void ThreadPool::Submit(std::function<void()> job)
+{
+	// Workers push to their own queue, other threads spread the jobs round robin
+	const int workerIndex = GetCurrentWorkerIndex();
+	const unsigned int queueIndex = workerIndex >= 0
+		? static_cast<unsigned int>(workerIndex)
+		: nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+
+	{
+		std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+		queues[queueIndex]->jobs.push_back(std::move(job));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		numQueuedJobs++;
+	}
+	wakeUp.notify_one();
+}
+
+void ThreadPool::Submit(std::function<void()> job, JobCounter& counter)
+{
+	counter.pendingJobs.fetch_add(1, std::memory_order_relaxed);
+	Submit([job = std::move(job), &counter]() {
+		job();
+		counter.pendingJobs.fetch_sub(1, std::memory_order_release);
+	});
+}
+
+void ThreadPool::SubmitBackground(std::function<void()> job, JobCounter& counter)
+{
+	counter.pendingJobs.fetch_add(1, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(backgroundQueue.mutex);
+		backgroundQueue.jobs.push_back([job = std::move(job), &counter]() {
+			job();
+			counter.pendingJobs.fetch_sub(1, std::memory_order_release);
+		});
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		numQueuedJobs++;
+	}
+	wakeUp.notify_one();
+}
+
+bool ThreadPool::PopJob(unsigned int queueIndex, std::function<void()>& job)
+{
+	WorkQueue& queue = *queues[queueIndex];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+
+	if (queue.jobs.empty()) {
+		return false;
+	}
+	job = std::move(queue.jobs.back());
+	queue.jobs.pop_back();
+	return true;
+}
+
+bool ThreadPool::StealJob(unsigned int thiefIndex, std::function<void()>& job)
+{
+	const unsigned int numQueues = static_cast<unsigned int>(queues.size());
+
+	for (unsigned int i = 1; i <= numQueues; i++) {
+		WorkQueue& queue = *queues[(thiefIndex + i) % numQueues];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (!queue.jobs.empty()) {
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ThreadPool::TryRunPendingJob()
+{
+	std::function<void()> job;
+	const int workerIndex = GetCurrentWorkerIndex();
+	const bool isWorker = workerIndex >= 0;
+	const unsigned int queueIndex = isWorker ? static_cast<unsigned int>(workerIndex) : 0;
+
+	if (!(isWorker && PopJob(queueIndex, job)) && !StealJob(queueIndex, job)) {
+		return false;
+	}
+
+	numQueuedJobs--;
+	job();
+	return true;
+}
+
+bool ThreadPool::TryRunBackgroundJob()
+{
+	std::function<void()> job;
+	{
+		std::lock_guard<std::mutex> lock(backgroundQueue.mutex);
+		if (backgroundQueue.jobs.empty()) {
+			return false;
+		}
+		job = std::move(backgroundQueue.jobs.front());
+		backgroundQueue.jobs.pop_front();
+	}
+
+	numQueuedJobs--;
+	job();
+	return true;
+}
+
+void ThreadPool::Wait(const JobCounter& counter)
+{
+	while (!counter.IsDone()) {
+		if (!TryRunPendingJob()) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void ThreadPool::ParallelFor(int count, int grainSize, const std::function<void(int, int)>& func)
+{
+	if (count <= grainSize) {
+		func(0, count);
+		return;
+	}
+
+	// Queue every range but the first one, the calling thread handles that one itself
+	JobCounter counter;
+	for (int begin = grainSize; begin < count; begin += grainSize) {
+		const int end = std::min(begin + grainSize, count);
+		Submit([&func, begin, end]() {
+			func(begin, end);
+		}, counter);
+	}
+
+	func(0, grainSize);
+	Wait(counter);
+}
+
+void ThreadPool::WorkerLoop(unsigned int workerIndex)
+{
+	currentPool = this;
+	currentWorkerIndex = static_cast<int>(workerIndex);
+
+	while (true) {
+		// Frame jobs first, background jobs only when there are none
+		if (TryRunPendingJob() || TryRunBackgroundJob()) {
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wakeUp.wait(lock, [this]() { return !isRunning || numQueuedJobs > 0; });
+
+		if (!isRunning && numQueuedJobs == 0) {
+			return;
+		}
+	}
+}
@@ -0,0 +1,83 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Counts the jobs of a group that have not finished yet
+/// </summary>
+class JobCounter {
+private:
+	std::atomic<int> pendingJobs{ 0 };
+	friend class ThreadPool;
+public:
+	bool IsDone() const { return pendingJobs.load(std::memory_order_acquire) == 0; }
+};
+
+/// <summary>
+/// Work stealing thread pool. Every worker owns a job queue, it pops its own jobs
+/// from the back and steals from the front of the other queues when it runs dry
+/// </summary>
+class ThreadPool {
+private:
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> jobs;
+	};
+
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+	// Jobs no frame waits on, kept away from the queues TryRunPendingJob takes from
+	WorkQueue backgroundQueue;
+	std::vector<std::thread> workers;
+
+	std::atomic<bool> isRunning{ true };
+	std::atomic<int> numQueuedJobs{ 0 };
+	std::atomic<unsigned int> nextQueue{ 0 };
+
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+
+	bool PopJob(unsigned int queueIndex, std::function<void()>& job);
+	bool StealJob(unsigned int thiefIndex, std::function<void()>& job);
+	void WorkerLoop(unsigned int workerIndex);
+public:
+	/// numWorkers = 0 uses one worker per hardware thread, minus the calling thread
+	explicit ThreadPool(unsigned int numWorkers = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator =(const ThreadPool&) = delete;
+
+	void Submit(std::function<void()> job);
+	void Submit(std::function<void()> job, JobCounter& counter);
+	/// <summary>
+	/// Queues a long running job that no frame waits on, like decoding an asset. Only idle workers
+	/// pick it up: TryRunPendingJob never runs it, so Wait and the scheduler cannot stall on it
+	/// </summary>
+	void SubmitBackground(std::function<void()> job, JobCounter& counter);
+
+	/// Runs one queued job on the calling thread, returns false if there was none
+	bool TryRunPendingJob();
+	/// Runs the oldest background job on the calling thread, for threads blocked on background work
+	bool TryRunBackgroundJob();
+	/// Helps running queued jobs until every job of counter has finished
+	void Wait(const JobCounter& counter);
+
+	/// <summary>
+	/// Splits [0, count) in ranges of grainSize and calls func(begin, end) for each range on the pool.
+	/// Returns once every range has been processed, the calling thread works on ranges too
+	/// </summary>
+	void ParallelFor(int count, int grainSize, const std::function<void(int, int)>& func);
+
+	unsigned int GetNumWorkers() const { return static_cast<unsigned int>(workers.size()); }
+	/// Index of the calling thread among the workers of this pool, -1 on threads that are not its workers
+	int GetCurrentWorkerIndex() const;
+};
+
+#endif // !THREADPOOL_H
@@ -1,11 +1,113 @@
 #include <iostream>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <string>
+#include <vector>
 #include "Game/Game.h"
+#include "Profiler/Profiler.h"
+#include "Tilemap/Tilemap.h"
+#include "Logger/Logger.h"
+
+static const char* CONVERT_MAP_USAGE = "Usage : --convert-map <out.tmb> <layer.map>... [--tileset-cols N] [--tile-size N]";
+static const char* USAGE = "Usage : [--headless] [--ticks N] [--profile <trace.json>] | --convert-map <out.tmb> <layer.map>...";
+
+// Parses text as a whole number above 0, anything else (letters, trailing characters, overflow) is rejected
+static bool ParsePositiveInt(const char* text, int& value) {
+    char* end = nullptr;
+    errno = 0;
+    const long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed <= 0 || parsed > INT_MAX) {
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+// --convert-map <out.tmb> <layer.map>... [--tileset-cols N] [--tile-size N]
+// converts text maps, one per layer, to a binary tilemap file and exits
+static int ConvertMap(int argc, char* argv[], int first) {
+    std::string binaryPath;
+    std::vector<std::string> textPaths;
+    int tilesetCols = 10;
+    int tileSize = 32;
+    for (int i = first; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--tileset-cols" && i + 1 < argc) {
+            if (!ParsePositiveInt(argv[++i], tilesetCols)) {
+                std::cout << "--tileset-cols expects a number above 0, got " << argv[i] << std::endl;
+                std::cout << CONVERT_MAP_USAGE << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--tile-size" && i + 1 < argc) {
+            if (!ParsePositiveInt(argv[++i], tileSize)) {
+                std::cout << "--tile-size expects a number above 0, got " << argv[i] << std::endl;
+                std::cout << CONVERT_MAP_USAGE << std::endl;
+                return 1;
+            }
+        }
+        else if (binaryPath.empty()) {
+            binaryPath = arg;
+        }
+        else {
+            textPaths.push_back(arg);
+        }
+    }
+
+    if (binaryPath.empty() || textPaths.empty()) {
+        std::cout << CONVERT_MAP_USAGE << std::endl;
+        return 1;
+    }
+
+    Logger logManager;
+    logManager.Initialize();
+    const bool isConverted = Tilemap::ConvertTextToBinary(textPaths, binaryPath, tilesetCols, tileSize);
+    logManager.Destroy();
+    return isConverted ? 0 : 1;
+}
 
 int main(int argc, char* argv[]) {
+    // --headless runs the simulation without a window, --ticks sets how many ticks it runs
+    // and --profile writes the profiler's Chrome trace once it is done
+    bool isHeadless = false;
+    int numTicks = 10000;
+    std::string profilePath;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--headless") {
+            isHeadless = true;
+        }
+        else if (arg == "--ticks" && i + 1 < argc) {
+            if (!ParsePositiveInt(argv[++i], numTicks)) {
+                std::cout << "--ticks expects a number above 0, got " << argv[i] << std::endl;
+                std::cout << USAGE << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--profile" && i + 1 < argc) {
+            profilePath = argv[++i];
+        }
+        else if (arg == "--convert-map") {
+            return ConvertMap(argc, argv, i + 1);
+        }
+    }
+
     Game game;
 
-    game.Initialize();
-    game.Run();
+    if (isHeadless) {
+        game.InitializeHeadless();
+        const double ticksPerSecond = game.RunHeadless(numTicks);
+        std::cout << numTicks << " ticks, " << ticksPerSecond << " ticks per second" << std::endl;
+    }
+    else {
+        game.Initialize();
+        game.Run();
+    }
+
+    if (!profilePath.empty() && !Profiler::WriteChromeTrace(profilePath)) {
+        std::cout << "Could not write profile trace to " << profilePath << std::endl;
+    }
     game.Destroy();
 
     return 0;
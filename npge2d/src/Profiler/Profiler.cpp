@@ -0,0 +1,201 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+
+namespace {
+	// Fixed size history, the oldest sample is overwritten
+	struct FrameRing {
+		float samples[Profiler::FRAME_HISTORY] = {};
+		int next = 0;
+		int count = 0;
+
+		void Push(float sample) {
+			samples[next] = sample;
+			next = (next + 1) % Profiler::FRAME_HISTORY;
+			count = std::min(count + 1, Profiler::FRAME_HISTORY);
+		}
+
+		float GetLast() const {
+			return count > 0 ? samples[(next + Profiler::FRAME_HISTORY - 1) % Profiler::FRAME_HISTORY] : 0.0f;
+		}
+
+		std::vector<float> GetOrdered() const {
+			std::vector<float> ordered;
+			ordered.reserve(count);
+			for (int i = 0; i < count; i++) {
+				ordered.push_back(samples[(next - count + i + Profiler::FRAME_HISTORY) % Profiler::FRAME_HISTORY]);
+			}
+			return ordered;
+		}
+	};
+
+	struct Zone {
+		std::string name;
+		// Time spent in the zone since the last EndFrame
+		double frameMs = 0.0;
+		FrameRing history;
+	};
+
+	struct TraceEvent {
+		int zoneId;
+		int threadIndex;
+		std::int64_t startNs;
+		std::int64_t durationNs;
+	};
+
+	std::mutex profilerMutex;
+	std::vector<Zone> zones;
+	FrameRing frameHistory;
+	const Profiler::Clock::time_point epoch = Profiler::Clock::now();
+	Profiler::Clock::time_point frameStart = epoch;
+
+	std::vector<TraceEvent> traceEvents;
+	std::size_t nextTraceEvent = 0;
+
+	std::atomic<int> numThreads{ 0 };
+	thread_local int threadIndex = -1;
+
+	int GetThreadIndex() {
+		if (threadIndex < 0) {
+			threadIndex = numThreads++;
+		}
+		return threadIndex;
+	}
+
+	ZoneStats ComputeStats(const std::string& name, const FrameRing& ring) {
+		ZoneStats stats;
+		stats.name = name;
+		stats.numFrames = ring.count;
+		if (ring.count == 0) {
+			return stats;
+		}
+
+		std::vector<float> samples = ring.GetOrdered();
+		stats.lastMs = samples.back();
+
+		double sum = 0.0;
+		for (float sample : samples) {
+			sum += sample;
+		}
+		stats.avgMs = sum / samples.size();
+
+		auto p99 = samples.begin() + static_cast<std::ptrdiff_t>(0.99 * (samples.size() - 1));
+		std::nth_element(samples.begin(), p99, samples.end());
+		stats.p99Ms = *p99;
+		stats.minMs = *std::min_element(samples.begin(), samples.end());
+		return stats;
+	}
+
+	void WriteEscaped(std::ofstream& file, const std::string& text) {
+		for (char ch : text) {
+			if (ch == '"' || ch == '\\') {
+				file << '\\';
+			}
+			file << ch;
+		}
+	}
+}
+
+int Profiler::RegisterZone(const char* name)
+{
+	std::lock_guard<std::mutex> lock(profilerMutex);
+	for (int zoneId = 0; zoneId < static_cast<int>(zones.size()); zoneId++) {
+		if (zones[zoneId].name == name) {
+			return zoneId;
+		}
+	}
+	Zone zone;
+	zone.name = name;
+	zones.push_back(zone);
+	return static_cast<int>(zones.size()) - 1;
+}
+
+void Profiler::Record(int zoneId, Clock::time_point start, Clock::time_point end)
+{
+	const TraceEvent event = {
+		zoneId,
+		GetThreadIndex(),
+		std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch).count(),
+		std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()
+	};
+
+	std::lock_guard<std::mutex> lock(profilerMutex);
+	zones[zoneId].frameMs += event.durationNs / 1.0e6;
+
+	// Oldest events are overwritten once the trace buffer is full
+	if (traceEvents.size() < MAX_TRACE_EVENTS) {
+		traceEvents.push_back(event);
+	}
+	else {
+		traceEvents[nextTraceEvent] = event;
+	}
+	nextTraceEvent = (nextTraceEvent + 1) % MAX_TRACE_EVENTS;
+}
+
+void Profiler::EndFrame()
+{
+	const Clock::time_point now = Clock::now();
+
+	std::lock_guard<std::mutex> lock(profilerMutex);
+	frameHistory.Push(std::chrono::duration<float, std::milli>(now - frameStart).count());
+	frameStart = now;
+
+	for (auto& zone : zones) {
+		zone.history.Push(static_cast<float>(zone.frameMs));
+		zone.frameMs = 0.0;
+	}
+}
+
+std::vector<ZoneStats> Profiler::GetZoneStats()
+{
+	std::lock_guard<std::mutex> lock(profilerMutex);
+	std::vector<ZoneStats> stats;
+	for (const auto& zone : zones) {
+		stats.push_back(ComputeStats(zone.name, zone.history));
+	}
+	return stats;
+}
+
+ZoneStats Profiler::GetFrameStats()
+{
+	std::lock_guard<std::mutex> lock(profilerMutex);
+	return ComputeStats("Frame", frameHistory);
+}
+
+std::vector<float> Profiler::GetFrameTimes()
+{
+	std::lock_guard<std::mutex> lock(profilerMutex);
+	return frameHistory.GetOrdered();
+}
+
+bool Profiler::WriteChromeTrace(const std::string& filePath)
+{
+	std::ofstream file(filePath);
+	if (!file) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(profilerMutex);
+
+	// Complete events ("ph":"X"), times are in microseconds
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	const std::size_t numEvents = traceEvents.size();
+	const std::size_t firstEvent = numEvents < MAX_TRACE_EVENTS ? 0 : nextTraceEvent;
+	for (std::size_t i = 0; i < numEvents; i++) {
+		const TraceEvent& event = traceEvents[(firstEvent + i) % numEvents];
+		file << (i > 0 ? ",\n" : "\n") << "{\"name\":\"";
+		WriteEscaped(file, zones[event.zoneId].name);
+		file << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.threadIndex
+			<< ",\"ts\":" << event.startNs / 1000.0
+			<< ",\"dur\":" << event.durationNs / 1000.0 << "}";
+	}
+	file << "\n]}\n";
+
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,79 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Timings of one zone over the recorded frames, in milliseconds.
+/// A zone entered several times in a frame counts the sum of its durations
+/// </summary>
+struct ZoneStats {
+	std::string name;
+	double lastMs = 0.0;
+	double minMs = 0.0;
+	double avgMs = 0.0;
+	double p99Ms = 0.0;
+	int numFrames = 0;
+};
+
+/// <summary>
+/// Frame profiler. Zones are timed with NPGE_PROFILE_SCOPE, NPGE_PROFILE_FRAME closes a frame.
+/// The last FRAME_HISTORY frames are kept per zone, the last MAX_TRACE_EVENTS zone timings
+/// are kept for Chrome trace output (chrome://tracing or ui.perfetto.dev)
+/// </summary>
+class Profiler
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	static constexpr int FRAME_HISTORY = 256;
+	static constexpr int MAX_TRACE_EVENTS = 64 * 1024;
+
+	/// Returns the id of the zone called name, registering it the first time
+	static int RegisterZone(const char* name);
+	static void Record(int zoneId, Clock::time_point start, Clock::time_point end);
+	static void EndFrame();
+
+	static std::vector<ZoneStats> GetZoneStats();
+	/// Duration of the whole frame, from one EndFrame to the next
+	static ZoneStats GetFrameStats();
+	/// Frame durations in milliseconds, oldest first
+	static std::vector<float> GetFrameTimes();
+
+	/// <summary>
+	/// Writes the recorded zone timings as Chrome trace JSON, returns false if the file cannot be written
+	/// </summary>
+	static bool WriteChromeTrace(const std::string& filePath);
+};
+
+/// <summary>
+/// Times its own lifetime into a zone
+/// </summary>
+class ProfileScope
+{
+private:
+	int zoneId;
+	Profiler::Clock::time_point start;
+public:
+	explicit ProfileScope(int zoneId) : zoneId(zoneId), start(Profiler::Clock::now()) {}
+	~ProfileScope() { Profiler::Record(zoneId, start, Profiler::Clock::now()); }
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator =(const ProfileScope&) = delete;
+};
+
+#define NPGE_PROFILE_CONCAT_INNER(a, b)	a##b
+#define NPGE_PROFILE_CONCAT(a, b)		NPGE_PROFILE_CONCAT_INNER(a, b)
+
+#ifndef NPGE_CONFIG_RELEASE
+// The zone is registered once per call site, a scope only reads the clock twice
+#define NPGE_PROFILE_SCOPE(name)	static const int NPGE_PROFILE_CONCAT(npgeProfileZone, __LINE__) = Profiler::RegisterZone(name); \
+									ProfileScope NPGE_PROFILE_CONCAT(npgeProfileScope, __LINE__)(NPGE_PROFILE_CONCAT(npgeProfileZone, __LINE__))
+#define NPGE_PROFILE_FRAME()		Profiler::EndFrame()
+#else
+#define NPGE_PROFILE_SCOPE(name)	(void)0
+#define NPGE_PROFILE_FRAME()		(void)0
+#endif
+
+#endif // !PROFILER_H
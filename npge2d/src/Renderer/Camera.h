@@ -0,0 +1,39 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <glm/glm.hpp>
+
+#include "../Spatial/SpatialHashGrid.h"
+
+/// <summary>
+/// View into the world. position is the world pixel shown at the top left of the viewport,
+/// zoom scales world pixels to screen pixels
+/// </summary>
+struct Camera {
+	glm::vec2 position;
+	float zoom;
+	int viewportWidth;
+	int viewportHeight;
+
+	Camera(glm::vec2 position = glm::vec2(0, 0), float zoom = 1.0f, int viewportWidth = 0, int viewportHeight = 0) {
+		this->position = position;
+		this->zoom = zoom;
+		this->viewportWidth = viewportWidth;
+		this->viewportHeight = viewportHeight;
+	}
+
+	/// Part of the world that is on screen
+	AABB GetViewRect() const {
+		return { position.x, position.y, position.x + viewportWidth / zoom, position.y + viewportHeight / zoom };
+	}
+
+	glm::vec2 WorldToScreen(glm::vec2 worldPosition) const {
+		return (worldPosition - position) * zoom;
+	}
+
+	glm::vec2 ScreenToWorld(glm::vec2 screenPosition) const {
+		return position + screenPosition / zoom;
+	}
+};
+
+#endif // !CAMERA_H
@@ -0,0 +1,104 @@
+#include "SpriteBatch.h"
+
+#include <cmath>
+
+void SpriteBatch::Begin(SDL_Renderer* renderer)
+{
+	this->renderer = renderer;
+	texture = nullptr;
+	numSprites = 0;
+	numDrawCalls = 0;
+}
+
+void SpriteBatch::Draw(const TextureRegion& region, const SDL_Rect& srcRect, const SDL_Rect& destRect, double rotation)
+{
+	if (!region.texture) {
+		return;
+	}
+
+	// The source rect is relative to the image, move it to where the image sits in its texture
+	SDL_Rect textureRect = { region.rect.x + srcRect.x, region.rect.y + srcRect.y, srcRect.w, srcRect.h };
+	numSprites++;
+
+#if NPGE_SPRITEBATCH_GEOMETRY
+	// A texture switch ends the batch so that sprites stay in the order they were submitted
+	if (region.texture != texture) {
+		Flush();
+		texture = region.texture;
+	}
+
+	const float u0 = static_cast<float>(textureRect.x) / region.textureWidth;
+	const float v0 = static_cast<float>(textureRect.y) / region.textureHeight;
+	const float u1 = static_cast<float>(textureRect.x + textureRect.w) / region.textureWidth;
+	const float v1 = static_cast<float>(textureRect.y + textureRect.h) / region.textureHeight;
+
+	const float halfWidth = destRect.w * 0.5f;
+	const float halfHeight = destRect.h * 0.5f;
+	const float centerX = destRect.x + halfWidth;
+	const float centerY = destRect.y + halfHeight;
+
+	// Same convention as SDL_RenderCopyEx, y points down so a positive angle turns clockwise
+	const double radians = rotation * M_PI / 180.0;
+	const float cosine = static_cast<float>(std::cos(radians));
+	const float sine = static_cast<float>(std::sin(radians));
+
+	const float corners[4][2] = {
+		{ -halfWidth, -halfHeight },
+		{ halfWidth, -halfHeight },
+		{ halfWidth, halfHeight },
+		{ -halfWidth, halfHeight }
+	};
+	const float texCoords[4][2] = { { u0, v0 }, { u1, v0 }, { u1, v1 }, { u0, v1 } };
+
+	const int firstVertex = static_cast<int>(vertices.size());
+	for (int i = 0; i < 4; i++) {
+		SDL_Vertex vertex;
+		vertex.position.x = centerX + corners[i][0] * cosine - corners[i][1] * sine;
+		vertex.position.y = centerY + corners[i][0] * sine + corners[i][1] * cosine;
+		vertex.color = { 255, 255, 255, 255 };
+		vertex.tex_coord.x = texCoords[i][0];
+		vertex.tex_coord.y = texCoords[i][1];
+		vertices.push_back(vertex);
+	}
+
+	const int quadIndices[6] = { 0, 1, 2, 0, 2, 3 };
+	for (int index : quadIndices) {
+		indices.push_back(firstVertex + index);
+	}
+#else
+	// Sprites from one atlas page still share a texture, which lets SDL's own batching merge the copies
+	if (region.texture != texture) {
+		texture = region.texture;
+		numDrawCalls++;
+	}
+	SDL_RenderCopyEx(renderer, region.texture, &textureRect, &destRect, rotation, NULL, SDL_FLIP_NONE);
+#endif
+}
+
+void SpriteBatch::End()
+{
+	Flush();
+	texture = nullptr;
+}
+
+void SpriteBatch::Flush()
+{
+#if NPGE_SPRITEBATCH_GEOMETRY
+	if (indices.empty()) {
+		return;
+	}
+
+	SDL_RenderGeometry(
+		renderer,
+		texture,
+		vertices.data(),
+		static_cast<int>(vertices.size()),
+		indices.data(),
+		static_cast<int>(indices.size())
+	);
+	numDrawCalls++;
+
+	vertices.clear();
+	indices.clear();
+#endif
+}
@@ -0,0 +1,48 @@
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include <vector>
+
+#include <SDL.h>
+
+#include "../AssetStore/AssetStore.h"
+
+// SDL_RenderGeometry only exists from SDL 2.0.18, older SDL falls back to one copy per sprite
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+#define NPGE_SPRITEBATCH_GEOMETRY 1
+#else
+#define NPGE_SPRITEBATCH_GEOMETRY 0
+#endif
+
+/// <summary>
+/// Collects sprite quads in submission order and draws consecutive quads
+/// sharing a texture (an atlas page) with one SDL_RenderGeometry call
+/// </summary>
+class SpriteBatch
+{
+private:
+	SDL_Renderer* renderer = nullptr;
+	SDL_Texture* texture = nullptr;
+#if NPGE_SPRITEBATCH_GEOMETRY
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> indices;
+#endif
+	int numSprites = 0;
+	int numDrawCalls = 0;
+
+	void Flush();
+public:
+	SpriteBatch() = default;
+
+	void Begin(SDL_Renderer* renderer);
+	/// <summary>
+	/// Queues a sprite. srcRect is relative to the region, rotation is in degrees clockwise around the sprite's center
+	/// </summary>
+	void Draw(const TextureRegion& region, const SDL_Rect& srcRect, const SDL_Rect& destRect, double rotation);
+	void End();
+
+	int GetNumSprites() const { return numSprites; }
+	int GetNumDrawCalls() const { return numDrawCalls; }
+};
+
+#endif // !SPRITEBATCH_H
@@ -0,0 +1,123 @@
+#include "SpatialHashGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialHashGrid::SpatialHashGrid(float cellSize)
+	: cellSize(cellSize), inverseCellSize(1.0f / cellSize)
+{
+}
+
+SpatialHashGrid::CellRange SpatialHashGrid::GetCellRange(const AABB& box) const
+{
+	return {
+		static_cast<int>(std::floor(box.minX * inverseCellSize)),
+		static_cast<int>(std::floor(box.minY * inverseCellSize)),
+		static_cast<int>(std::floor(box.maxX * inverseCellSize)),
+		static_cast<int>(std::floor(box.maxY * inverseCellSize))
+	};
+}
+
+void SpatialHashGrid::AddToCells(int id, const CellRange& range)
+{
+	for (int y = range.minY; y <= range.maxY; y++) {
+		for (int x = range.minX; x <= range.maxX; x++) {
+			cells[GetCellKey(x, y)].push_back(id);
+		}
+	}
+}
+
+void SpatialHashGrid::RemoveFromCells(int id, const CellRange& range)
+{
+	for (int y = range.minY; y <= range.maxY; y++) {
+		for (int x = range.minX; x <= range.maxX; x++) {
+			auto cell = cells.find(GetCellKey(x, y));
+			if (cell == cells.end()) {
+				continue;
+			}
+
+			// Cells are small, a swap and pop keeps removal cheap
+			std::vector<int>& ids = cell->second;
+			auto it = std::find(ids.begin(), ids.end(), id);
+			if (it != ids.end()) {
+				*it = ids.back();
+				ids.pop_back();
+			}
+			if (ids.empty()) {
+				cells.erase(cell);
+			}
+		}
+	}
+}
+
+std::uint32_t SpatialHashGrid::NextQueryStamp() const
+{
+	if (queryStamps.size() < items.size()) {
+		queryStamps.resize(items.size(), 0);
+	}
+
+	// Restart the stamps before they wrap around
+	if (++queryStamp == 0) {
+		std::fill(queryStamps.begin(), queryStamps.end(), 0);
+		queryStamp = 1;
+	}
+	return queryStamp;
+}
+
+void SpatialHashGrid::Insert(int id, const AABB& box)
+{
+	if (id >= static_cast<int>(items.size())) {
+		items.resize(id + 1);
+	}
+
+	Item& item = items[id];
+	if (item.isInserted) {
+		Update(id, box);
+		return;
+	}
+
+	item.box = box;
+	item.cells = GetCellRange(box);
+	item.isInserted = true;
+	AddToCells(id, item.cells);
+	numItems++;
+}
+
+void SpatialHashGrid::Update(int id, const AABB& box)
+{
+	if (!Contains(id)) {
+		Insert(id, box);
+		return;
+	}
+
+	Item& item = items[id];
+	item.box = box;
+
+	const CellRange range = GetCellRange(box);
+	if (range == item.cells) {
+		return;
+	}
+	RemoveFromCells(id, item.cells);
+	AddToCells(id, range);
+	item.cells = range;
+}
+
+void SpatialHashGrid::Remove(int id)
+{
+	if (!Contains(id)) {
+		return;
+	}
+
+	Item& item = items[id];
+	RemoveFromCells(id, item.cells);
+	item.isInserted = false;
+	numItems--;
+}
+
+void SpatialHashGrid::Clear()
+{
+	cells.clear();
+	items.clear();
+	queryStamps.clear();
+	numItems = 0;
+}
@@ -0,0 +1,144 @@
+#ifndef SPATIALHASHGRID_H
+#define SPATIALHASHGRID_H
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Axis aligned box in world pixels
+/// </summary>
+struct AABB {
+	float minX = 0.0f;
+	float minY = 0.0f;
+	float maxX = 0.0f;
+	float maxY = 0.0f;
+
+	// Evaluates all four tests without branching, most tests in a broad phase fail unpredictably
+	bool Overlaps(const AABB& other) const {
+		return (minX < other.maxX) & (other.minX < maxX) & (minY < other.maxY) & (other.minY < maxY);
+	}
+};
+
+/// <summary>
+/// Uniform grid of square cells over an unbounded world, only cells holding something are stored.
+/// Items are identified by a non negative id (an entity id) and are binned in every cell their box touches
+/// </summary>
+class SpatialHashGrid
+{
+private:
+	struct CellRange {
+		int minX, minY, maxX, maxY;
+
+		bool operator ==(const CellRange& other) const {
+			return minX == other.minX && minY == other.minY && maxX == other.maxX && maxY == other.maxY;
+		}
+	};
+
+	struct Item {
+		AABB box;
+		CellRange cells;
+		bool isInserted = false;
+	};
+
+	struct CellKeyHash {
+		std::size_t operator ()(std::uint64_t key) const {
+			// Mix the packed coordinates, neighbouring cells must not share buckets
+			key ^= key >> 33;
+			key *= 0xff51afd7ed558ccdull;
+			key ^= key >> 33;
+			return static_cast<std::size_t>(key);
+		}
+	};
+
+	float cellSize;
+	float inverseCellSize;
+	std::unordered_map<std::uint64_t, std::vector<int>, CellKeyHash> cells;
+	// [index = item id]
+	std::vector<Item> items;
+	int numItems = 0;
+
+	// Items spanning several cells are reported once per query by stamping them
+	mutable std::vector<std::uint32_t> queryStamps;
+	mutable std::uint32_t queryStamp = 0;
+
+	static std::uint64_t GetCellKey(int x, int y) {
+		return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(y);
+	}
+
+	CellRange GetCellRange(const AABB& box) const;
+	void AddToCells(int id, const CellRange& range);
+	void RemoveFromCells(int id, const CellRange& range);
+	std::uint32_t NextQueryStamp() const;
+public:
+	explicit SpatialHashGrid(float cellSize = 128.0f);
+
+	void Insert(int id, const AABB& box);
+	/// Only touches the cells when the box moved to a different set of cells
+	void Update(int id, const AABB& box);
+	void Remove(int id);
+	void Clear();
+
+	bool Contains(int id) const { return id >= 0 && id < static_cast<int>(items.size()) && items[id].isInserted; }
+	const AABB& GetBox(int id) const { return items[id].box; }
+	int GetNumItems() const { return numItems; }
+	int GetNumCells() const { return static_cast<int>(cells.size()); }
+	float GetCellSize() const { return cellSize; }
+
+	/// <summary>
+	/// Calls func(id) once for every item whose box overlaps region
+	/// </summary>
+	template <typename TFunc>
+	void Query(const AABB& region, TFunc&& func) const {
+		const CellRange range = GetCellRange(region);
+		const std::uint32_t stamp = NextQueryStamp();
+
+		for (int y = range.minY; y <= range.maxY; y++) {
+			for (int x = range.minX; x <= range.maxX; x++) {
+				auto cell = cells.find(GetCellKey(x, y));
+				if (cell == cells.end()) {
+					continue;
+				}
+				for (int id : cell->second) {
+					if (queryStamps[id] != stamp && items[id].box.Overlaps(region)) {
+						queryStamps[id] = stamp;
+						func(id);
+					}
+				}
+			}
+		}
+	}
+
+	/// Appends the ids of the items overlapping region to result
+	void Query(const AABB& region, std::vector<int>& result) const {
+		Query(region, [&result](int id) { result.push_back(id); });
+	}
+
+	/// <summary>
+	/// Calls func(idA, idB) once for every pair of overlapping items.
+	/// Two items can share several cells, the pair is only reported from the cell holding the top left corner of their overlap
+	/// </summary>
+	template <typename TFunc>
+	void QueryPairs(TFunc&& func) const {
+		for (const auto& cell : cells) {
+			const std::vector<int>& ids = cell.second;
+			for (std::size_t i = 0; i < ids.size(); i++) {
+				const AABB& a = items[ids[i]].box;
+				for (std::size_t j = i + 1; j < ids.size(); j++) {
+					const AABB& b = items[ids[j]].box;
+					if (!a.Overlaps(b)) {
+						continue;
+					}
+					const float overlapX = a.minX > b.minX ? a.minX : b.minX;
+					const float overlapY = a.minY > b.minY ? a.minY : b.minY;
+					if (GetCellKey(static_cast<int>(std::floor(overlapX * inverseCellSize)), static_cast<int>(std::floor(overlapY * inverseCellSize))) == cell.first) {
+						func(ids[i], ids[j]);
+					}
+				}
+			}
+		}
+	}
+};
+
+#endif // !SPATIALHASHGRID_H
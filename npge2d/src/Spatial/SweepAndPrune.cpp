@@ -0,0 +1,148 @@
+#include "SweepAndPrune.h"
+
+#include <algorithm>
+
+void SweepAndPrune::Insert(int id, const AABB& box)
+{
+	if (id >= static_cast<int>(boxes.size())) {
+		boxes.resize(id + 1);
+		isInserted.resize(id + 1, false);
+		activeIndex.resize(id + 1, -1);
+	}
+	if (isInserted[id]) {
+		boxes[id] = box;
+		return;
+	}
+
+	// Removed endpoints of a reused id have to go before the id gets new ones
+	if (hasRemovedItems) {
+		RefreshEndpoints();
+	}
+
+	boxes[id] = box;
+	isInserted[id] = true;
+	numItems++;
+
+	// Appended unsorted, they are merged in by the next sort
+	endpoints.push_back({ box.minX, (id << 1) | 1 });
+	endpoints.push_back({ box.maxX, id << 1 });
+}
+
+void SweepAndPrune::Update(int id, const AABB& box)
+{
+	if (!Contains(id)) {
+		Insert(id, box);
+		return;
+	}
+	boxes[id] = box;
+}
+
+void SweepAndPrune::Remove(int id)
+{
+	if (!Contains(id)) {
+		return;
+	}
+	isInserted[id] = false;
+	numItems--;
+	hasRemovedItems = true;
+}
+
+void SweepAndPrune::Clear()
+{
+	boxes.clear();
+	isInserted.clear();
+	activeIndex.clear();
+	activeBoxes.clear();
+	endpoints.clear();
+	numSortedEndpoints = 0;
+	pairs.clear();
+	numItems = 0;
+	hasRemovedItems = false;
+}
+
+void SweepAndPrune::RefreshEndpoints()
+{
+	// Drop the endpoints of removed boxes without disturbing the order of the others
+	if (hasRemovedItems) {
+		auto isRemoved = [this](const Endpoint& endpoint) {
+			return !isInserted[endpoint.GetId()];
+		};
+		const auto sortedEnd = std::remove_if(endpoints.begin(), endpoints.begin() + numSortedEndpoints, isRemoved);
+		const auto end = std::remove_if(endpoints.begin() + numSortedEndpoints, endpoints.end(), isRemoved);
+		// Keep the unsorted tail right after the sorted part
+		const auto newEnd = std::move(endpoints.begin() + numSortedEndpoints, end, sortedEnd);
+		numSortedEndpoints = sortedEnd - endpoints.begin();
+		endpoints.erase(newEnd, endpoints.end());
+		hasRemovedItems = false;
+	}
+
+	for (auto& endpoint : endpoints) {
+		const AABB& box = boxes[endpoint.GetId()];
+		endpoint.value = endpoint.IsMin() ? box.minX : box.maxX;
+	}
+}
+
+void SweepAndPrune::SortEndpoints()
+{
+	// Each endpoint only travels as far as its box moved past others since the last frame
+	for (std::size_t i = 1; i < numSortedEndpoints; i++) {
+		const Endpoint endpoint = endpoints[i];
+		std::size_t j = i;
+		while (j > 0 && IsBefore(endpoint, endpoints[j - 1])) {
+			endpoints[j] = endpoints[j - 1];
+			j--;
+		}
+		endpoints[j] = endpoint;
+	}
+
+	// New endpoints can land anywhere, they are sorted apart and merged in
+	if (numSortedEndpoints < endpoints.size()) {
+		std::sort(endpoints.begin() + numSortedEndpoints, endpoints.end(), IsBefore);
+		std::inplace_merge(endpoints.begin(), endpoints.begin() + numSortedEndpoints, endpoints.end(), IsBefore);
+		numSortedEndpoints = endpoints.size();
+	}
+}
+
+void SweepAndPrune::Sweep()
+{
+	pairs.clear();
+	activeBoxes.clear();
+
+	for (const auto& endpoint : endpoints) {
+		const int id = endpoint.GetId();
+
+		if (!endpoint.IsMin()) {
+			// An empty box may see its max first, it never became active
+			const int index = activeIndex[id];
+			if (index >= 0) {
+				activeIndex[activeBoxes.back().id] = index;
+				activeBoxes[index] = activeBoxes.back();
+				activeBoxes.pop_back();
+				activeIndex[id] = -1;
+			}
+			continue;
+		}
+
+		const AABB& box = boxes[id];
+		if (box.minX >= box.maxX) {
+			continue;
+		}
+
+		// Every active box overlaps this one on x, only y is left to test
+		for (const auto& other : activeBoxes) {
+			if ((box.minY < other.maxY) & (other.minY < box.maxY)) {
+				pairs.push_back(other.id < id ? std::make_pair(other.id, id) : std::make_pair(id, other.id));
+			}
+		}
+
+		activeIndex[id] = static_cast<int>(activeBoxes.size());
+		activeBoxes.push_back({ box.minY, box.maxY, id });
+	}
+}
+
+void SweepAndPrune::UpdatePairs()
+{
+	RefreshEndpoints();
+	SortEndpoints();
+	Sweep();
+}
@@ -0,0 +1,94 @@
+#ifndef SWEEPANDPRUNE_H
+#define SWEEPANDPRUNE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "SpatialHashGrid.h"
+
+/// <summary>
+/// Sort and sweep broad phase on the x axis. The sorted endpoint list is kept between
+/// frames and re-sorted with an insertion sort, which is close to linear when objects
+/// only move a little every tick
+/// </summary>
+class SweepAndPrune
+{
+private:
+	struct Endpoint {
+		float value;
+		// id << 1, low bit set for the min endpoint of the box
+		int idAndType;
+
+		int GetId() const { return idAndType >> 1; }
+		bool IsMin() const { return (idAndType & 1) != 0; }
+	};
+
+	// Sorted on x, a box that ends where another begins comes first so touching boxes do not pair up
+	static bool IsBefore(const Endpoint& a, const Endpoint& b) {
+		return a.value < b.value || (a.value == b.value && !a.IsMin() && b.IsMin());
+	}
+
+	// [index = item id]
+	std::vector<AABB> boxes;
+	std::vector<bool> isInserted;
+	int numItems = 0;
+
+	std::vector<Endpoint> endpoints;
+	// Endpoints past this one were inserted since the last sort
+	std::size_t numSortedEndpoints = 0;
+	bool hasRemovedItems = false;
+
+	// Sweep state, the boxes whose min was passed but not their max.
+	// Their y extents are copied in so the inner loop reads contiguous memory
+	struct ActiveBox {
+		float minY;
+		float maxY;
+		int id;
+	};
+	std::vector<ActiveBox> activeBoxes;
+	// Position in activeBoxes [index = item id], -1 when not active
+	std::vector<int> activeIndex;
+
+	std::vector<std::pair<int, int>> pairs;
+
+	void RefreshEndpoints();
+	void SortEndpoints();
+	void Sweep();
+public:
+	SweepAndPrune() = default;
+
+	void Insert(int id, const AABB& box);
+	/// Only stores the box, the endpoints move during the next UpdatePairs
+	void Update(int id, const AABB& box);
+	void Remove(int id);
+	void Clear();
+
+	bool Contains(int id) const { return id >= 0 && id < static_cast<int>(isInserted.size()) && isInserted[id]; }
+	int GetNumItems() const { return numItems; }
+
+	/// <summary>
+	/// Re-sorts the endpoints from the current boxes and collects the overlapping pairs
+	/// </summary>
+	void UpdatePairs();
+
+	/// Overlapping pairs found by the last UpdatePairs, the lower id first
+	const std::vector<std::pair<int, int>>& GetPairs() const { return pairs; }
+
+	/// <summary>
+	/// Calls func(id) for every item overlapping region, as sorted by the last UpdatePairs.
+	/// Only the endpoints left of the region's right edge are visited
+	/// </summary>
+	template <typename TFunc>
+	void Query(const AABB& region, TFunc&& func) const {
+		for (const auto& endpoint : endpoints) {
+			if (endpoint.value >= region.maxX) {
+				break;
+			}
+			if (endpoint.IsMin() && isInserted[endpoint.GetId()] && boxes[endpoint.GetId()].Overlaps(region)) {
+				func(endpoint.GetId());
+			}
+		}
+	}
+};
+
+#endif // !SWEEPANDPRUNE_H
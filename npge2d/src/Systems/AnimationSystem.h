@@ -2,6 +2,7 @@
 #define ANIMATIONSYSTEM_H
 
 #include "../ECS/ECS.h"
+#include "../Profiler/Profiler.h"
 #include "../Components/SpriteComponent.h"
 #include "../Components/AnimationComponent.h"
 
@@ -10,16 +11,16 @@ public:
 	AnimationSystem() {
 		RequireComponent<SpriteComponent>();
 		RequireComponent<AnimationComponent>();
+		WritesComponent<SpriteComponent>();
+		WritesComponent<AnimationComponent>();
 	}
 
 	void Update() {
-		for (auto entity : GetSystemEntities()) {
-			auto& animation = entity.GetComponent<AnimationComponent>();
-			auto& sprite = entity.GetComponent<SpriteComponent>();
-
+		NPGE_PROFILE_SCOPE("AnimationSystem::Update");
+		ForEach<AnimationComponent, SpriteComponent>([](Entity, AnimationComponent& animation, SpriteComponent& sprite) {
 			animation.currentFrame = ((SDL_GetTicks() - animation.startTime) * animation.frameRateSpeed / 1000) % animation.numFrames;
 			sprite.srcRect.x = animation.currentFrame * sprite.width;
-		}
+		});
 	}
 };
 
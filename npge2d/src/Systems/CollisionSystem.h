@@ -0,0 +1,199 @@
+#ifndef COLLISIONSYSTEM_H
+#define COLLISIONSYSTEM_H
+
+#include "../Logger/Log.h"
+
+#include "../ECS/ECS.h"
+#include "../Profiler/Profiler.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/BoxColliderComponent.h"
+#include "../Spatial/SpatialHashGrid.h"
+#include "../Spatial/SweepAndPrune.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// Two entities whose box colliders overlap
+/// </summary>
+struct CollisionPair {
+	Entity a;
+	Entity b;
+};
+
+/// <summary>
+/// How the candidate pairs are found. The grid suits scattered colliders of similar sizes,
+/// sweep and prune suits clusters and colliders of very different sizes
+/// </summary>
+enum class BroadPhase {
+	SpatialHash,
+	SweepAndPrune
+};
+
+class CollisionSystem : public System
+{
+private:
+	BroadPhase broadPhase;
+	// Broad phase, the colliders are moved in the grid or the sweep as their transforms change
+	SpatialHashGrid colliderGrid;
+	SweepAndPrune colliderSweep;
+	// Entity handles of the ids stored in the broad phase [index = entityid]
+	std::vector<Entity> colliderEntities;
+
+	// Sorted by GetPairKey so two frames can be compared
+	std::vector<CollisionPair> collisions;
+	std::vector<CollisionPair> previousCollisions;
+	std::vector<CollisionPair> collisionsBegan;
+	std::vector<CollisionPair> collisionsEnded;
+
+	// Id and generation of an entity, a recycled id makes a different key
+	static std::uint64_t GetEntityKey(Entity entity) {
+		return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(entity.GetId())) << 32) | static_cast<std::uint32_t>(entity.GetGeneration());
+	}
+
+	// Smaller entity key first, so a pair has one key whatever the order of its entities
+	static std::pair<std::uint64_t, std::uint64_t> GetPairKey(const CollisionPair& pair) {
+		const std::uint64_t keyA = GetEntityKey(pair.a);
+		const std::uint64_t keyB = GetEntityKey(pair.b);
+		return keyA < keyB ? std::make_pair(keyA, keyB) : std::make_pair(keyB, keyA);
+	}
+
+	static bool IsPairBefore(const CollisionPair& a, const CollisionPair& b) {
+		return GetPairKey(a) < GetPairKey(b);
+	}
+
+	bool IsCollider(int entityId) const {
+		return entityId >= 0 && entityId < static_cast<int>(colliderEntities.size()) && colliderEntities[entityId].GetId() != -1;
+	}
+
+	void AddCollision(int entityIdA, int entityIdB) {
+		// Only ids added through OnEntityAdded have a handle, anything else in the broad phase is ignored
+		if (!IsCollider(entityIdA) || !IsCollider(entityIdB)) {
+			NPGE_WARN("Collision Pair [{0},{1}] has an Entity unknown to the CollisionSystem", entityIdA, entityIdB);
+			return;
+		}
+		collisions.push_back({ colliderEntities[entityIdA], colliderEntities[entityIdB] });
+	}
+
+protected:
+	void OnEntityAdded(Entity entity) override {
+		const auto entityId = entity.GetId();
+		if (entityId >= static_cast<int>(colliderEntities.size())) {
+			colliderEntities.resize(entityId + 1, Entity(-1));
+		}
+		colliderEntities[entityId] = entity;
+
+		const AABB bounds = GetColliderBounds(entity.GetComponent<TransformComponent>(), entity.GetComponent<BoxColliderComponent>());
+		if (broadPhase == BroadPhase::SpatialHash) {
+			colliderGrid.Insert(entityId, bounds);
+		}
+		else {
+			colliderSweep.Insert(entityId, bounds);
+		}
+	}
+
+	void OnEntityRemoved(Entity entity) override {
+		if (broadPhase == BroadPhase::SpatialHash) {
+			colliderGrid.Remove(entity.GetId());
+		}
+		else {
+			colliderSweep.Remove(entity.GetId());
+		}
+		colliderEntities[entity.GetId()] = Entity(-1);
+	}
+
+public:
+	// Colliders are usually about a sprite in size, a few of them share a cell
+	static constexpr float DEFAULT_CELL_SIZE = 128.0f;
+
+	CollisionSystem(BroadPhase broadPhase = BroadPhase::SpatialHash, float cellSize = DEFAULT_CELL_SIZE)
+		: broadPhase(broadPhase), colliderGrid(cellSize) {
+		RequireComponent<TransformComponent>();
+		RequireComponent<BoxColliderComponent>();
+	}
+
+	static AABB GetColliderBounds(const TransformComponent& transform, const BoxColliderComponent& collider) {
+		const float minX = transform.position.x + collider.offset.x * transform.scale.x;
+		const float minY = transform.position.y + collider.offset.y * transform.scale.y;
+		return { minX, minY, minX + collider.width * transform.scale.x, minY + collider.height * transform.scale.y };
+	}
+
+	void Update() {
+		NPGE_PROFILE_SCOPE("CollisionSystem::Update");
+		collisions.swap(previousCollisions);
+		collisions.clear();
+
+		if (broadPhase == BroadPhase::SpatialHash) {
+			// Re-bin from this frame's transforms, only colliders that crossed a cell border touch the cells
+			ForEach<TransformComponent, BoxColliderComponent>([this](Entity entity, TransformComponent& transform, BoxColliderComponent& collider) {
+				colliderGrid.Update(entity.GetId(), GetColliderBounds(transform, collider));
+			});
+			colliderGrid.QueryPairs([this](int entityIdA, int entityIdB) {
+				AddCollision(entityIdA, entityIdB);
+			});
+		}
+		else {
+			ForEach<TransformComponent, BoxColliderComponent>([this](Entity entity, TransformComponent& transform, BoxColliderComponent& collider) {
+				colliderSweep.Update(entity.GetId(), GetColliderBounds(transform, collider));
+			});
+			colliderSweep.UpdatePairs();
+			for (const auto& pair : colliderSweep.GetPairs()) {
+				AddCollision(pair.first, pair.second);
+			}
+		}
+
+		// Pairs only in this frame began, pairs only in the previous frame ended
+		std::sort(collisions.begin(), collisions.end(), IsPairBefore);
+		collisionsBegan.clear();
+		collisionsEnded.clear();
+		std::set_difference(collisions.begin(), collisions.end(), previousCollisions.begin(), previousCollisions.end(), std::back_inserter(collisionsBegan), IsPairBefore);
+		std::set_difference(previousCollisions.begin(), previousCollisions.end(), collisions.begin(), collisions.end(), std::back_inserter(collisionsEnded), IsPairBefore);
+	}
+
+	/// Pairs of entities that overlapped during the last Update
+	const std::vector<CollisionPair>& GetCollisions() const {
+		return collisions;
+	}
+
+	/// Pairs that started overlapping during the last Update
+	const std::vector<CollisionPair>& GetCollisionsBegan() const {
+		return collisionsBegan;
+	}
+
+	/// <summary>
+	/// Pairs that stopped overlapping during the last Update, including pairs whose entity was killed
+	/// </summary>
+	const std::vector<CollisionPair>& GetCollisionsEnded() const {
+		return collisionsEnded;
+	}
+
+	/// <summary>
+	/// Appends the entities whose collider overlaps region, as of the last Update
+	/// </summary>
+	void QueryRegion(const AABB& region, std::vector<Entity>& result) const {
+		auto addEntity = [this, &result](int entityId) {
+			if (IsCollider(entityId)) {
+				result.push_back(colliderEntities[entityId]);
+			}
+		};
+		if (broadPhase == BroadPhase::SpatialHash) {
+			colliderGrid.Query(region, addEntity);
+		}
+		else {
+			colliderSweep.Query(region, addEntity);
+		}
+	}
+
+	BroadPhase GetBroadPhase() const {
+		return broadPhase;
+	}
+
+	const SpatialHashGrid& GetColliderGrid() const {
+		return colliderGrid;
+	}
+};
+
+#endif // !COLLISIONSYSTEM_H
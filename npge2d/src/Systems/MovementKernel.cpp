@@ -0,0 +1,67 @@
+#include "MovementKernel.h"
+
+// x64 always has SSE2, 32 bit builds only when the compiler targets it
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NPGE_KERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace MovementKernel {
+	// Kernels use a separate multiply and add (no FMA) so every path rounds exactly like the scalar one
+
+	void IntegrateScalar(float* positions, std::size_t positionStride, const float* velocities, std::size_t velocityStride, std::size_t count, float deltaTime)
+	{
+		for (std::size_t i = 0; i < count; i++) {
+			positions[0] += velocities[0] * deltaTime;
+			positions[1] += velocities[1] * deltaTime;
+			positions += positionStride;
+			velocities += velocityStride;
+		}
+	}
+
+#ifdef NPGE_KERNEL_SSE2
+	// x,y pairs of 2 entities in one register, packed pairs are read in a single load
+	static inline __m128 LoadPairs(const float* pairs, std::size_t stride)
+	{
+		if (stride == 2) {
+			return _mm_loadu_ps(pairs);
+		}
+		const __m128 low = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(pairs));
+		return _mm_loadh_pi(low, reinterpret_cast<const __m64*>(pairs + stride));
+	}
+
+	static inline void StorePairs(float* pairs, std::size_t stride, __m128 values)
+	{
+		if (stride == 2) {
+			_mm_storeu_ps(pairs, values);
+			return;
+		}
+		_mm_storel_pi(reinterpret_cast<__m64*>(pairs), values);
+		_mm_storeh_pi(reinterpret_cast<__m64*>(pairs + stride), values);
+	}
+#endif
+
+	void IntegrateSSE2(float* positions, std::size_t positionStride, const float* velocities, std::size_t velocityStride, std::size_t count, float deltaTime)
+	{
+#ifdef NPGE_KERNEL_SSE2
+		const __m128 dt = _mm_set1_ps(deltaTime);
+		std::size_t i = 0;
+
+		// 4 floats per instruction, 2 entities
+		for (; i + 2 <= count; i += 2) {
+			float* position = positions + i * positionStride;
+			const __m128 velocity = LoadPairs(velocities + i * velocityStride, velocityStride);
+			StorePairs(position, positionStride, _mm_add_ps(LoadPairs(position, positionStride), _mm_mul_ps(velocity, dt)));
+		}
+		IntegrateScalar(positions + i * positionStride, positionStride, velocities + i * velocityStride, velocityStride, count - i, deltaTime);
+#else
+		IntegrateScalar(positions, positionStride, velocities, velocityStride, count, deltaTime);
+#endif
+	}
+
+	void Integrate(float* positions, std::size_t positionStride, const float* velocities, std::size_t velocityStride, std::size_t count, float deltaTime)
+	{
+		// SSE2 is known at compile time, the kernel itself falls back to the scalar loop without it
+		IntegrateSSE2(positions, positionStride, velocities, velocityStride, count, deltaTime);
+	}
+}
@@ -0,0 +1,19 @@
+#ifndef MOVEMENTKERNEL_H
+#define MOVEMENTKERNEL_H
+
+#include <cstddef>
+
+/// <summary>
+/// Integration kernels for count entities: position += velocity * deltaTime.
+/// Positions and velocities are x,y float pairs read in place from component arrays,
+/// the pairs of consecutive entities are positionStride / velocityStride floats apart
+/// </summary>
+namespace MovementKernel {
+	void IntegrateScalar(float* positions, std::size_t positionStride, const float* velocities, std::size_t velocityStride, std::size_t count, float deltaTime);
+	void IntegrateSSE2(float* positions, std::size_t positionStride, const float* velocities, std::size_t velocityStride, std::size_t count, float deltaTime);
+
+	/// Dispatches to the widest kernel the build supports
+	void Integrate(float* positions, std::size_t positionStride, const float* velocities, std::size_t velocityStride, std::size_t count, float deltaTime);
+}
+
+#endif // !MOVEMENTKERNEL_H
@@ -4,30 +4,36 @@
 #include "../Logger/Log.h"
 
 #include "../ECS/ECS.h"
+#include "../Profiler/Profiler.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/RigidBodyComponent.h"
+#include "MovementKernel.h"
 
 class MovementSystem : public System
 {
 private:
+	// Distance in floats between the x,y pairs of two consecutive components in a column
+	static constexpr std::size_t POSITION_STRIDE = sizeof(TransformComponent) / sizeof(float);
+	static constexpr std::size_t VELOCITY_STRIDE = sizeof(RigidBodyComponent) / sizeof(float);
+	static_assert(sizeof(TransformComponent) % sizeof(float) == 0 && sizeof(RigidBodyComponent) % sizeof(float) == 0,
+		"Movement kernels step through the components in whole floats");
 public:
 	MovementSystem() {
 		RequireComponent<TransformComponent>();
 		RequireComponent<RigidBodyComponent>();
+		WritesComponent<TransformComponent>();
+		OwnsComponents<TransformComponent, RigidBodyComponent>();
 	}
 
 	void Update(double deltaTime) {
-		// TODO: 
-		// Loop all entities that the system is interested in
-		for (auto entity : GetSystemEntities()) {
-			auto& transform = entity.GetComponent<TransformComponent>();
-			const auto rigidbody = entity.GetComponent<RigidBodyComponent>();
+		NPGE_PROFILE_SCOPE("MovementSystem::Update");
+		const float dt = static_cast<float>(deltaTime);
 
-			transform.position.x += rigidbody.velocity.x * deltaTime;
-			transform.position.y += rigidbody.velocity.y * deltaTime;
-
-			//NPGE_DEBUG("Entity ID : {0} -> Position [{1},{2}]", entity.GetId(), transform.position.x, transform.position.y);
-		}
+		// Transforms and velocities of consecutive entities sit side by side, in the archetype columns or in the
+		// owned pools, the kernel integrates them in place
+		ParallelForEachBatch<TransformComponent, RigidBodyComponent>([dt](const Entity*, int count, TransformComponent* transforms, RigidBodyComponent* rigidbodies) {
+			MovementKernel::Integrate(&transforms->position.x, POSITION_STRIDE, &rigidbodies->velocity.x, VELOCITY_STRIDE, count, dt);
+		});
 	}
 };
 
@@ -4,77 +4,292 @@
 #include "../Logger/Log.h"
 
 #include "../ECS/ECS.h"
+#include "../Profiler/Profiler.h"
 #include "../AssetStore/AssetStore.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/SpriteComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include "../Renderer/Camera.h"
+#include "../Renderer/SpriteBatch.h"
+#include "../Spatial/SpatialHashGrid.h"
 
 #include <SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
 
 
 class RenderSystem : public System
 {
 private:
+	// Entities of one zIndex, kept in insertion order. Removed entities leave a hole
+	// (negative id) that is compacted away before the layer is drawn
+	struct RenderLayer {
+		std::vector<Entity> entities;
+		int numRemoved = 0;
+		// Slots of the entities under the camera this frame, filled by CullSprites
+		std::vector<int> visibleSlots;
+	};
+
+	// Where an entity sits in the layers [index = entityid]
+	struct RenderSlot {
+		int zIndex;
+		int slot;
+		// Index in dynamicEntities, -1 for entities that are binned once
+		int dynamicSlot;
+	};
+
+	// Layers ordered by zIndex, the order is maintained on add/remove instead of sorted every frame
+	std::map<int, RenderLayer> layers;
+	std::vector<RenderSlot> renderSlots;
+	// Draws of consecutive sprites sharing an atlas page are merged
+	SpriteBatch spriteBatch;
+
+	// World bounds of every sprite, only the cells under the camera are visited when drawing
+	SpatialHashGrid spriteGrid{ 256.0f };
+	// Entities with a RigidBody are re-binned each frame, the others keep the bounds they were added with
+	std::vector<Entity> dynamicEntities;
+
+	// Transform of the dynamic entities before the last simulation tick [index = dynamicSlot],
+	// they are drawn between that and their current transform
+	struct TransformState {
+		glm::vec2 position;
+		double rotation;
+	};
+	std::vector<TransformState> previousTransforms;
+
+	static AABB GetSpriteBounds(const TransformComponent& transform, const SpriteComponent& sprite) {
+		const float width = sprite.width * transform.scale.x;
+		const float height = sprite.height * transform.scale.y;
+		if (transform.rotation == 0.0) {
+			return { transform.position.x, transform.position.y, transform.position.x + width, transform.position.y + height };
+		}
+
+		// Rotated around the center, the box is the circle through the corners
+		const float radius = 0.5f * std::sqrt(width * width + height * height);
+		const float centerX = transform.position.x + 0.5f * width;
+		const float centerY = transform.position.y + 0.5f * height;
+		return { centerX - radius, centerY - radius, centerX + radius, centerY + radius };
+	}
+
+	void UpdateSpriteBounds(Entity entity) {
+		spriteGrid.Update(entity.GetId(), GetSpriteBounds(entity.GetComponent<TransformComponent>(), entity.GetComponent<SpriteComponent>()));
+	}
+
+	void InsertIntoLayer(Entity entity, int zIndex) {
+		const auto entityId = entity.GetId();
+		if (entityId >= static_cast<int>(renderSlots.size())) {
+			renderSlots.resize(entityId + 1);
+		}
+
+		RenderLayer& layer = layers[zIndex];
+		renderSlots[entityId].zIndex = zIndex;
+		renderSlots[entityId].slot = static_cast<int>(layer.entities.size());
+		layer.entities.push_back(entity);
+	}
+
+	void RemoveFromLayer(Entity entity) {
+		const RenderSlot& renderSlot = renderSlots[entity.GetId()];
+		RenderLayer& layer = layers[renderSlot.zIndex];
+
+		layer.entities[renderSlot.slot] = Entity(-1);
+		layer.numRemoved++;
+	}
+
+	void CompactLayer(RenderLayer& layer) {
+		int slot = 0;
+		for (auto entity : layer.entities) {
+			if (entity.GetId() >= 0) {
+				renderSlots[entity.GetId()].slot = slot;
+				layer.entities[slot++] = entity;
+			}
+		}
+		layer.entities.resize(slot, Entity(-1));
+		layer.numRemoved = 0;
+	}
+
+	/// <summary>
+	/// Buckets the sprites under the camera into the visibleSlots of their layer. Only those sprites are
+	/// looked at: a zIndex change is applied when the sprite is next on screen, before it is drawn
+	/// </summary>
+	void CullSprites(const Camera& camera) {
+		for (auto entity : dynamicEntities) {
+			UpdateSpriteBounds(entity);
+		}
+
+		for (auto layerIt = layers.begin(); layerIt != layers.end();) {
+			RenderLayer& layer = layerIt->second;
+			if (layer.numRemoved > 0) {
+				CompactLayer(layer);
+			}
+			if (layer.entities.empty()) {
+				layerIt = layers.erase(layerIt);
+				continue;
+			}
+			++layerIt;
+		}
+
+		spriteGrid.Query(camera.GetViewRect(), [this](int entityId) {
+			const RenderSlot& renderSlot = renderSlots[entityId];
+			const Entity entity = layers[renderSlot.zIndex].entities[renderSlot.slot];
+
+			const int zIndex = entity.GetComponent<SpriteComponent>().zIndex;
+			if (zIndex != renderSlot.zIndex) {
+				RemoveFromLayer(entity);
+				InsertIntoLayer(entity, zIndex);
+			}
+			layers[zIndex].visibleSlots.push_back(renderSlot.slot);
+		});
+
+		// Grid order depends on the cells, slots restore the insertion order of each layer
+		for (auto& layer : layers) {
+			std::sort(layer.second.visibleSlots.begin(), layer.second.visibleSlots.end());
+		}
+	}
+
+	void AddDynamicEntity(Entity entity) {
+		const auto& transform = entity.GetComponent<TransformComponent>();
+		renderSlots[entity.GetId()].dynamicSlot = static_cast<int>(dynamicEntities.size());
+		dynamicEntities.push_back(entity);
+		previousTransforms.push_back({ transform.position, transform.rotation });
+	}
+
+	void RemoveDynamicEntity(Entity entity) {
+		const int dynamicSlot = renderSlots[entity.GetId()].dynamicSlot;
+		dynamicEntities[dynamicSlot] = dynamicEntities.back();
+		previousTransforms[dynamicSlot] = previousTransforms.back();
+		renderSlots[dynamicEntities[dynamicSlot].GetId()].dynamicSlot = dynamicSlot;
+		dynamicEntities.pop_back();
+		previousTransforms.pop_back();
+		renderSlots[entity.GetId()].dynamicSlot = -1;
+	}
+
+protected:
+	void OnEntityAdded(Entity entity) override {
+		InsertIntoLayer(entity, entity.GetComponent<SpriteComponent>().zIndex);
+		UpdateSpriteBounds(entity);
+
+		renderSlots[entity.GetId()].dynamicSlot = -1;
+		if (entity.HasComponent<RigidBodyComponent>()) {
+			AddDynamicEntity(entity);
+		}
+	}
+
+	void OnEntityRemoved(Entity entity) override {
+		RemoveFromLayer(entity);
+		spriteGrid.Remove(entity.GetId());
+
+		if (renderSlots[entity.GetId()].dynamicSlot >= 0) {
+			RemoveDynamicEntity(entity);
+		}
+	}
+
+	// A RigidBody added or removed later makes the sprite start or stop being re-binned every frame
+	void OnEntityComponentsChanged(Entity entity) override {
+		const bool isDynamic = entity.HasComponent<RigidBodyComponent>();
+		if (isDynamic == (renderSlots[entity.GetId()].dynamicSlot >= 0)) {
+			return;
+		}
+
+		if (isDynamic) {
+			AddDynamicEntity(entity);
+		}
+		else {
+			// Bin it where it stopped, it is not moved by the simulation anymore
+			RemoveDynamicEntity(entity);
+			UpdateSpriteBounds(entity);
+		}
+	}
+
 public:
 	RenderSystem() {
 		RequireComponent<TransformComponent>();
 		RequireComponent<SpriteComponent>();
+		WatchesComponent<RigidBodyComponent>();
 	}
 
-	void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore) {
-		// Sort all entities of our system by z-index
-		struct RenderableEntity {
-			TransformComponent transformComponent;
-			SpriteComponent spriteComponent;
-		};
-		std::vector<RenderableEntity> renderableEntities;
-		for (auto entity : GetSystemEntities()) {
-			RenderableEntity rE;
-			rE.spriteComponent = entity.GetComponent<SpriteComponent>();
-			rE.transformComponent = entity.GetComponent<TransformComponent>();
-			renderableEntities.emplace_back(rE);
+	/// <summary>
+	/// Call when a sprite without a RigidBody was moved or resized by hand, those are not re-binned every frame
+	/// </summary>
+	void RefreshBounds(Entity entity) {
+		if (HasEntity(entity)) {
+			UpdateSpriteBounds(entity);
 		}
+	}
 
-		// TODO: Find a better place to sort the entities based on zIndex in the Render System
-		std::sort(renderableEntities.begin(), renderableEntities.end(), [](const RenderableEntity& a, const RenderableEntity& b) {
-			return a.spriteComponent.zIndex < b.spriteComponent.zIndex;
-		});
+	/// <summary>
+	/// Call before the last simulation tick of a frame, the frame is then drawn between the saved and the new transforms
+	/// </summary>
+	void SaveTransforms() {
+		for (std::size_t dynamicSlot = 0; dynamicSlot < dynamicEntities.size(); dynamicSlot++) {
+			const auto& transform = dynamicEntities[dynamicSlot].GetComponent<TransformComponent>();
+			previousTransforms[dynamicSlot] = { transform.position, transform.rotation };
+		}
+	}
+
+	/// <summary>
+	/// Entities under the camera in the order Update draws them, lowest zIndex first
+	/// </summary>
+	std::vector<Entity> GetVisibleEntities(const Camera& camera) {
+		CullSprites(camera);
+
+		std::vector<Entity> visibleEntities;
+		for (auto& layer : layers) {
+			for (auto slot : layer.second.visibleSlots) {
+				visibleEntities.push_back(layer.second.entities[slot]);
+			}
+			layer.second.visibleSlots.clear();
+		}
+		return visibleEntities;
+	}
+
+	/// <summary>
+	/// Draws the visible sprites. interpolation in [0, 1] is how far the frame is from the
+	/// saved transforms (0) to the current ones (1), only dynamic entities are interpolated
+	/// </summary>
+	void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const Camera& camera, double interpolation = 1.0) {
+		NPGE_PROFILE_SCOPE("RenderSystem::Update");
+		CullSprites(camera);
+
+		spriteBatch.Begin(renderer);
+
+		// Walk the visible sprites layer by layer, from the lowest zIndex up
+		for (auto& layer : layers) {
+			for (auto slot : layer.second.visibleSlots) {
+				const Entity entity = layer.second.entities[slot];
+				const auto& transform = entity.GetComponent<TransformComponent>();
+				const auto& sprite = entity.GetComponent<SpriteComponent>();
+
+				glm::vec2 position = transform.position;
+				double rotation = transform.rotation;
+				const int dynamicSlot = renderSlots[entity.GetId()].dynamicSlot;
+				if (dynamicSlot >= 0) {
+					const TransformState& previous = previousTransforms[dynamicSlot];
+					position = glm::mix(previous.position, transform.position, static_cast<float>(interpolation));
+					rotation = previous.rotation + (transform.rotation - previous.rotation) * interpolation;
+				}
+
+				// Set Source and Destination Rectangle of sprite
+				const glm::vec2 screenPosition = camera.WorldToScreen(position);
+				SDL_Rect srcRect = sprite.srcRect;
+				SDL_Rect destRect = {
+					static_cast<int>(screenPosition.x),
+					static_cast<int>(screenPosition.y),
+					static_cast<int>(sprite.width * transform.scale.x * camera.zoom),
+					static_cast<int>(sprite.height * transform.scale.y * camera.zoom)
+				};
 
-		// Loop all entities that the system is interested in
-		for (auto entity : renderableEntities) {
-			const auto transform = entity.transformComponent;
-			const auto sprite = entity.spriteComponent;
-
-			// Set Source and Destination Rectangle of sprite
-			SDL_Rect srcRect = sprite.srcRect;
-			SDL_Rect destRect = {
-				static_cast<int>(transform.position.x),
-				static_cast<int>(transform.position.y),
-				static_cast<int>(sprite.width * transform.scale.x),
-				static_cast<int>(sprite.height * transform.scale.y)
-			};
-
-			// Draw the PNG Texture
-			SDL_RenderCopyEx(
-				renderer, 
-				assetStore->GetTexture(sprite.assetId),
-				&srcRect,
-				&destRect,
-				transform.rotation,
-				NULL,
-				SDL_FLIP_NONE
-			);
-
-			// SDL Rect Drawing
-			/*SDL_Rect objRect = { 
-				static_cast<int>(transform.position.x),
-				static_cast<int>(transform.position.y),
-				sprite.width, 
-				sprite.height 
-			};
-
-			SDL_SetRenderDrawColor(renderer, 255,255,255,255);
-			SDL_RenderFillRect(renderer, &objRect);*/
+				// Queue the PNG Texture, srcRect is remapped into the atlas page by the batch
+				spriteBatch.Draw(
+					assetStore->GetTextureRegion(sprite.textureHandle),
+					srcRect,
+					destRect,
+					rotation
+				);
+			}
+			layer.second.visibleSlots.clear();
 		}
+		spriteBatch.End();
 	}
 };
 
@@ -0,0 +1,373 @@
+#include "Tilemap.h"
+
+#include "../Logger/Log.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+Tilemap::Tilemap(int numCols, int numRows, int tileSize, double tileScale, TextureHandle tileset)
+	: Tilemap(numCols, numRows, tileSize, tileScale, tileset, MappedFile(), nullptr)
+{
+}
+
+Tilemap::Tilemap(int numCols, int numRows, int tileSize, double tileScale, TextureHandle tileset, MappedFile&& file, const std::uint16_t* mappedTiles)
+	: numCols(numCols), numRows(numRows), tileSize(tileSize), tileScale(tileScale), tileset(tileset), tileData(mappedTiles), mappedFile(std::move(file))
+{
+	if (!tileData) {
+		tiles.assign(static_cast<std::size_t>(numCols) * numRows, EMPTY_TILE);
+		tileData = tiles.data();
+	}
+
+	numChunkCols = (numCols + CHUNK_TILES - 1) / CHUNK_TILES;
+	numChunkRows = (numRows + CHUNK_TILES - 1) / CHUNK_TILES;
+	chunks.resize(static_cast<std::size_t>(numChunkCols) * numChunkRows);
+}
+
+Tilemap::~Tilemap()
+{
+	InvalidateChunks();
+}
+
+bool Tilemap::LoadFromTextFile(const std::string& filePath, int tilesetCols)
+{
+	std::ifstream mapFile(filePath);
+	if (!mapFile) {
+		NPGE_ERROR("Failed to open tilemap {0}", filePath);
+		return false;
+	}
+
+	for (int row = 0; row < numRows; row++) {
+		for (int col = 0; col < numCols; col++) {
+			char tilesetRow = '0';
+			char tilesetCol = '0';
+			mapFile.get(tilesetRow);
+			mapFile.get(tilesetCol);
+			mapFile.ignore();
+			if (!mapFile) {
+				NPGE_ERROR("Tilemap {0} ends at tile ({1}, {2})", filePath, col, row);
+				return false;
+			}
+			SetTile(col, row, static_cast<std::uint16_t>((tilesetRow - '0') * tilesetCols + (tilesetCol - '0')));
+		}
+	}
+	return true;
+}
+
+std::unique_ptr<Tilemap> Tilemap::LoadFromBinaryFile(const std::string& filePath, double tileScale, TextureHandle tileset, int layer)
+{
+	MappedFile file;
+	if (!file.Open(filePath)) {
+		NPGE_ERROR("Failed to map tilemap {0}", filePath);
+		return nullptr;
+	}
+
+	TilemapFileHeader header;
+	if (file.GetSize() < sizeof(header)) {
+		NPGE_ERROR("Tilemap {0} is too small for its header", filePath);
+		return nullptr;
+	}
+	std::memcpy(&header, file.GetData(), sizeof(header));
+
+	if (std::memcmp(header.magic, TILEMAP_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != TILEMAP_FILE_VERSION) {
+		NPGE_ERROR("{0} is not a version {1} tilemap file", filePath, TILEMAP_FILE_VERSION);
+		return nullptr;
+	}
+	if (layer < 0 || static_cast<std::uint32_t>(layer) >= header.numLayers) {
+		NPGE_ERROR("Tilemap {0} has no layer {1}, it has {2}", filePath, layer, header.numLayers);
+		return nullptr;
+	}
+
+	// The header is not trusted: tile indices and chunk texture sizes are computed in int, and the layers
+	// are checked against the file size by division so a corrupt header cannot wrap the product around
+	const std::uint64_t maxInt = static_cast<std::uint64_t>(std::numeric_limits<int>::max());
+	const std::uint64_t numLayerTiles = static_cast<std::uint64_t>(header.numCols) * header.numRows;
+	if (header.tileSize == 0 || header.tileSize > maxInt / CHUNK_TILES || header.numCols > maxInt || header.numRows > maxInt || numLayerTiles > maxInt) {
+		NPGE_ERROR("Tilemap {0} has an invalid size : {1}x{2} tiles of {3} pixels", filePath, header.numCols, header.numRows, header.tileSize);
+		return nullptr;
+	}
+
+	const std::uint64_t maxTiles = (file.GetSize() - sizeof(header)) / sizeof(std::uint16_t);
+	if (numLayerTiles > maxTiles / header.numLayers) {
+		NPGE_ERROR("Tilemap {0} ends before its {1} layers", filePath, header.numLayers);
+		return nullptr;
+	}
+	const std::size_t layerSize = static_cast<std::size_t>(numLayerTiles) * sizeof(std::uint16_t);
+
+	// The header keeps the tile array 2 byte aligned inside the page aligned mapping
+	const std::uint16_t* layerTiles = reinterpret_cast<const std::uint16_t*>(file.GetData() + sizeof(header) + layerSize * layer);
+
+	NPGE_INFO("Tilemap {0} mapped : {1}x{2} tiles, layer {3} of {4}", filePath, header.numCols, header.numRows, layer, header.numLayers);
+	return std::unique_ptr<Tilemap>(new Tilemap(static_cast<int>(header.numCols), static_cast<int>(header.numRows),
+		static_cast<int>(header.tileSize), tileScale, tileset, std::move(file), layerTiles));
+}
+
+namespace {
+	// Reads a text map into tiles, the size of the map is counted from the text
+	bool ParseTextMap(const std::string& filePath, int tilesetCols, std::vector<std::uint16_t>& tiles, int& numCols, int& numRows)
+	{
+		std::ifstream mapFile(filePath);
+		if (!mapFile) {
+			NPGE_ERROR("Failed to open tilemap {0}", filePath);
+			return false;
+		}
+
+		tiles.clear();
+		numCols = 0;
+		numRows = 0;
+
+		std::string line;
+		while (std::getline(mapFile, line)) {
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+			if (line.empty()) {
+				continue;
+			}
+
+			int lineCols = 0;
+			std::stringstream lineStream(line);
+			std::string tile;
+			while (std::getline(lineStream, tile, ',')) {
+				// Two digits, the tileset row then the tileset column
+				if (tile.size() != 2 || !std::isdigit(static_cast<unsigned char>(tile[0])) || !std::isdigit(static_cast<unsigned char>(tile[1]))) {
+					NPGE_ERROR("Tilemap {0} has an invalid tile '{1}' at ({2}, {3})", filePath, tile, lineCols, numRows);
+					return false;
+				}
+				tiles.push_back(static_cast<std::uint16_t>((tile[0] - '0') * tilesetCols + (tile[1] - '0')));
+				lineCols++;
+			}
+
+			if (numRows > 0 && lineCols != numCols) {
+				NPGE_ERROR("Tilemap {0} row {1} has {2} tiles, expected {3}", filePath, numRows, lineCols, numCols);
+				return false;
+			}
+			numCols = lineCols;
+			numRows++;
+		}
+		return numRows > 0;
+	}
+}
+
+bool Tilemap::ConvertTextToBinary(const std::vector<std::string>& textFilePaths, const std::string& binaryFilePath, int tilesetCols, int tileSize)
+{
+	if (textFilePaths.empty()) {
+		return false;
+	}
+
+	TilemapFileHeader header;
+	std::memcpy(header.magic, TILEMAP_FILE_MAGIC, sizeof(header.magic));
+	header.version = TILEMAP_FILE_VERSION;
+	header.numLayers = static_cast<std::uint32_t>(textFilePaths.size());
+	header.tileSize = static_cast<std::uint32_t>(tileSize);
+
+	// Every layer covers the same grid as the first one
+	std::vector<std::uint16_t> layerTiles;
+	std::vector<std::uint16_t> allTiles;
+	for (std::size_t layer = 0; layer < textFilePaths.size(); layer++) {
+		int numCols, numRows;
+		if (!ParseTextMap(textFilePaths[layer], tilesetCols, layerTiles, numCols, numRows)) {
+			return false;
+		}
+		if (layer == 0) {
+			header.numCols = static_cast<std::uint32_t>(numCols);
+			header.numRows = static_cast<std::uint32_t>(numRows);
+		}
+		else if (static_cast<std::uint32_t>(numCols) != header.numCols || static_cast<std::uint32_t>(numRows) != header.numRows) {
+			NPGE_ERROR("Tilemap layer {0} is {1}x{2}, expected {3}x{4}", textFilePaths[layer], numCols, numRows, header.numCols, header.numRows);
+			return false;
+		}
+		allTiles.insert(allTiles.end(), layerTiles.begin(), layerTiles.end());
+	}
+
+	std::ofstream binaryFile(binaryFilePath, std::ios::binary);
+	binaryFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	binaryFile.write(reinterpret_cast<const char*>(allTiles.data()), static_cast<std::streamsize>(allTiles.size() * sizeof(std::uint16_t)));
+	if (!binaryFile) {
+		NPGE_ERROR("Failed to write tilemap {0}", binaryFilePath);
+		return false;
+	}
+
+	NPGE_INFO("Tilemap {0} written : {1}x{2} tiles, {3} layers", binaryFilePath, header.numCols, header.numRows, header.numLayers);
+	return true;
+}
+
+void Tilemap::SetTile(int col, int row, std::uint16_t tile)
+{
+	// Mapped tiles are read only, take a copy the first time the map is edited
+	if (mappedFile.IsOpen()) {
+		tiles.assign(tileData, tileData + static_cast<std::size_t>(numCols) * numRows);
+		tileData = tiles.data();
+		mappedFile.Close();
+	}
+
+	std::uint16_t& current = tiles[row * numCols + col];
+	if (current != tile) {
+		current = tile;
+		GetChunk(col / CHUNK_TILES, row / CHUNK_TILES).isDirty = true;
+	}
+}
+
+void Tilemap::InvalidateChunks()
+{
+	for (auto& chunk : chunks) {
+		ReleaseChunk(chunk);
+	}
+}
+
+SDL_Rect Tilemap::GetTileSrcRect(const TextureRegion& region, std::uint16_t tile) const
+{
+	const int tilesetCols = std::max(region.rect.w / tileSize, 1);
+	return {
+		region.rect.x + (tile % tilesetCols) * tileSize,
+		region.rect.y + (tile / tilesetCols) * tileSize,
+		tileSize,
+		tileSize
+	};
+}
+
+void Tilemap::BakeChunk(SDL_Renderer* renderer, const TextureRegion& region, Chunk& chunk, int chunkCol, int chunkRow)
+{
+	// Chunks are baked at the tileset's resolution, scaling happens when they are drawn
+	if (!chunk.texture) {
+		chunk.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, CHUNK_TILES * tileSize, CHUNK_TILES * tileSize);
+		if (!chunk.texture) {
+			NPGE_ERROR("Failed to create tilemap chunk texture : {0}", SDL_GetError());
+			return;
+		}
+		SDL_SetTextureBlendMode(chunk.texture, SDL_BLENDMODE_BLEND);
+		numBakedChunks++;
+	}
+
+	SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+	SDL_SetRenderTarget(renderer, chunk.texture);
+	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+	SDL_RenderClear(renderer);
+
+	const int firstCol = chunkCol * CHUNK_TILES;
+	const int firstRow = chunkRow * CHUNK_TILES;
+	const int lastCol = std::min(firstCol + CHUNK_TILES, numCols);
+	const int lastRow = std::min(firstRow + CHUNK_TILES, numRows);
+
+	for (int row = firstRow; row < lastRow; row++) {
+		for (int col = firstCol; col < lastCol; col++) {
+			const std::uint16_t tile = tileData[row * numCols + col];
+			if (tile == EMPTY_TILE) {
+				continue;
+			}
+			SDL_Rect srcRect = GetTileSrcRect(region, tile);
+			SDL_Rect destRect = { (col - firstCol) * tileSize, (row - firstRow) * tileSize, tileSize, tileSize };
+			SDL_RenderCopy(renderer, region.texture, &srcRect, &destRect);
+		}
+	}
+
+	SDL_SetRenderTarget(renderer, previousTarget);
+	chunk.isDirty = false;
+}
+
+void Tilemap::ReleaseChunk(Chunk& chunk)
+{
+	if (chunk.texture) {
+		SDL_DestroyTexture(chunk.texture);
+		chunk.texture = nullptr;
+		numBakedChunks--;
+	}
+	chunk.isDirty = true;
+}
+
+void Tilemap::EvictChunks()
+{
+	// Release the chunks drawn longest ago, the visible ones are never released
+	std::vector<Chunk*> offscreenChunks;
+	for (auto& chunk : chunks) {
+		if (chunk.texture && chunk.lastDrawnFrame != frame) {
+			offscreenChunks.push_back(&chunk);
+		}
+	}
+	std::sort(offscreenChunks.begin(), offscreenChunks.end(), [](const Chunk* a, const Chunk* b) {
+		return a->lastDrawnFrame < b->lastDrawnFrame;
+	});
+
+	for (auto chunk : offscreenChunks) {
+		if (numBakedChunks <= MAX_CACHED_CHUNKS) {
+			break;
+		}
+		ReleaseChunk(*chunk);
+	}
+}
+
+void Tilemap::RenderTiles(SDL_Renderer* renderer, const TextureRegion& region, const SDL_Rect& visibleTiles, const Camera& camera)
+{
+	const double scaledTileSize = GetScaledTileSize();
+	for (int row = visibleTiles.y; row < visibleTiles.y + visibleTiles.h; row++) {
+		for (int col = visibleTiles.x; col < visibleTiles.x + visibleTiles.w; col++) {
+			const std::uint16_t tile = tileData[row * numCols + col];
+			if (tile == EMPTY_TILE) {
+				continue;
+			}
+			// Snap both edges to whole pixels so neighbouring tiles neither overlap nor leave gaps
+			const glm::vec2 topLeft = camera.WorldToScreen(glm::vec2(col * scaledTileSize, row * scaledTileSize));
+			const glm::vec2 bottomRight = camera.WorldToScreen(glm::vec2((col + 1) * scaledTileSize, (row + 1) * scaledTileSize));
+			const int left = static_cast<int>(std::floor(topLeft.x));
+			const int top = static_cast<int>(std::floor(topLeft.y));
+			SDL_Rect srcRect = GetTileSrcRect(region, tile);
+			SDL_Rect destRect = { left, top, static_cast<int>(std::floor(bottomRight.x)) - left, static_cast<int>(std::floor(bottomRight.y)) - top };
+			SDL_RenderCopy(renderer, region.texture, &srcRect, &destRect);
+		}
+	}
+}
+
+void Tilemap::Render(SDL_Renderer* renderer, const std::unique_ptr<AssetStore>& assetStore, const Camera& camera)
+{
+	const TextureRegion& region = assetStore->GetTextureRegion(tileset);
+	if (!region.texture) {
+		return;
+	}
+	frame++;
+
+	// Tiles overlapping the camera, clamped to the map
+	const AABB view = camera.GetViewRect();
+	const double scaledTileSize = GetScaledTileSize();
+	const int firstCol = std::max(static_cast<int>(std::floor(view.minX / scaledTileSize)), 0);
+	const int firstRow = std::max(static_cast<int>(std::floor(view.minY / scaledTileSize)), 0);
+	const int lastCol = std::min(static_cast<int>(std::ceil(view.maxX / scaledTileSize)), numCols);
+	const int lastRow = std::min(static_cast<int>(std::ceil(view.maxY / scaledTileSize)), numRows);
+	if (firstCol >= lastCol || firstRow >= lastRow) {
+		return;
+	}
+
+	if (!SDL_RenderTargetSupported(renderer)) {
+		RenderTiles(renderer, region, { firstCol, firstRow, lastCol - firstCol, lastRow - firstRow }, camera);
+		return;
+	}
+
+	const double scaledChunkSize = CHUNK_TILES * scaledTileSize;
+	for (int chunkRow = firstRow / CHUNK_TILES; chunkRow <= (lastRow - 1) / CHUNK_TILES; chunkRow++) {
+		for (int chunkCol = firstCol / CHUNK_TILES; chunkCol <= (lastCol - 1) / CHUNK_TILES; chunkCol++) {
+			Chunk& chunk = GetChunk(chunkCol, chunkRow);
+			if (chunk.isDirty) {
+				BakeChunk(renderer, region, chunk, chunkCol, chunkRow);
+			}
+			if (!chunk.texture) {
+				continue;
+			}
+			chunk.lastDrawnFrame = frame;
+
+			// Snap both edges to whole pixels so neighbouring chunks neither overlap nor leave gaps
+			const glm::vec2 topLeft = camera.WorldToScreen(glm::vec2(chunkCol * scaledChunkSize, chunkRow * scaledChunkSize));
+			const glm::vec2 bottomRight = camera.WorldToScreen(glm::vec2((chunkCol + 1) * scaledChunkSize, (chunkRow + 1) * scaledChunkSize));
+			const int left = static_cast<int>(std::floor(topLeft.x));
+			const int top = static_cast<int>(std::floor(topLeft.y));
+			SDL_Rect destRect = { left, top, static_cast<int>(std::floor(bottomRight.x)) - left, static_cast<int>(std::floor(bottomRight.y)) - top };
+			SDL_RenderCopy(renderer, chunk.texture, NULL, &destRect);
+		}
+	}
+
+	if (numBakedChunks > MAX_CACHED_CHUNKS) {
+		EvictChunks();
+	}
+}
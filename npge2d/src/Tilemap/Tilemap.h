@@ -0,0 +1,124 @@
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+
+#include "../AssetStore/AssetStore.h"
+#include "../AssetStore/MappedFile.h"
+#include "../Renderer/Camera.h"
+
+/// <summary>
+/// Header of a binary tilemap file, followed by numLayers layers of numRows * numCols
+/// little endian uint16 tile indices, each layer laid out like Tilemap's tile grid
+/// </summary>
+struct TilemapFileHeader {
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t numCols;
+	std::uint32_t numRows;
+	std::uint32_t numLayers;
+	std::uint32_t tileSize;
+};
+static_assert(sizeof(TilemapFileHeader) == 24, "The tile array must start right after the header");
+
+const char TILEMAP_FILE_MAGIC[4] = { 'N', 'P', 'T', 'M' };
+const std::uint32_t TILEMAP_FILE_VERSION = 1;
+
+/// <summary>
+/// Static tile layer. Tiles are kept as indices into a tileset in a compact grid
+/// and drawn through chunks of CHUNK_TILES x CHUNK_TILES tiles baked into render target
+/// textures, so a frame costs one copy per visible chunk instead of one per tile
+/// </summary>
+class Tilemap
+{
+private:
+	struct Chunk {
+		SDL_Texture* texture = nullptr;
+		bool isDirty = true;
+		// Frame the chunk was last drawn in, used to evict chunks that went off screen
+		std::uint32_t lastDrawnFrame = 0;
+	};
+
+	int numCols;
+	int numRows;
+	int tileSize;
+	double tileScale;
+	TextureHandle tileset;
+
+	// Tile indices [index = row * numCols + col], a tile index is tilesetRow * tilesetCols + tilesetCol.
+	// Points into tiles, or straight into mappedFile for maps loaded from a binary file
+	const std::uint16_t* tileData;
+	std::vector<std::uint16_t> tiles;
+	// Binary map the tiles are read from in place, copied to tiles on the first SetTile
+	MappedFile mappedFile;
+
+	int numChunkCols;
+	int numChunkRows;
+	std::vector<Chunk> chunks;
+	int numBakedChunks = 0;
+	std::uint32_t frame = 0;
+
+	Chunk& GetChunk(int chunkCol, int chunkRow) { return chunks[chunkRow * numChunkCols + chunkCol]; }
+	SDL_Rect GetTileSrcRect(const TextureRegion& region, std::uint16_t tile) const;
+
+	void BakeChunk(SDL_Renderer* renderer, const TextureRegion& region, Chunk& chunk, int chunkCol, int chunkRow);
+	void ReleaseChunk(Chunk& chunk);
+	void EvictChunks();
+	// Used when the renderer cannot draw to textures
+	void RenderTiles(SDL_Renderer* renderer, const TextureRegion& region, const SDL_Rect& visibleTiles, const Camera& camera);
+
+	Tilemap(int numCols, int numRows, int tileSize, double tileScale, TextureHandle tileset, MappedFile&& file, const std::uint16_t* mappedTiles);
+public:
+	static constexpr int CHUNK_TILES = 16;
+	static constexpr std::uint16_t EMPTY_TILE = UINT16_MAX;
+	// Baked chunks kept around while off screen before the least recently drawn are released
+	static constexpr int MAX_CACHED_CHUNKS = 64;
+
+	Tilemap(int numCols, int numRows, int tileSize, double tileScale, TextureHandle tileset);
+	~Tilemap();
+	Tilemap(const Tilemap&) = delete;
+	Tilemap& operator =(const Tilemap&) = delete;
+
+	/// <summary>
+	/// Reads a text map where every tile is written as two digits, the tileset row then the tileset column,
+	/// and tiles are separated by one character. tilesetCols is the width of the tileset in tiles
+	/// </summary>
+	bool LoadFromTextFile(const std::string& filePath, int tilesetCols);
+
+	/// <summary>
+	/// Maps a binary tilemap file and draws from its tile array in place, nothing is parsed or copied.
+	/// Returns nullptr if the file is missing or malformed
+	/// </summary>
+	static std::unique_ptr<Tilemap> LoadFromBinaryFile(const std::string& filePath, double tileScale, TextureHandle tileset, int layer = 0);
+
+	/// <summary>
+	/// Converts text maps, one per layer, into a binary tilemap file. The size of the map is taken
+	/// from the first text map: one line per row, one comma separated tile per column
+	/// </summary>
+	static bool ConvertTextToBinary(const std::vector<std::string>& textFilePaths, const std::string& binaryFilePath, int tilesetCols, int tileSize);
+
+	/// Changing a tile re-bakes only the chunk that holds it
+	void SetTile(int col, int row, std::uint16_t tile);
+	std::uint16_t GetTile(int col, int row) const { return tileData[row * numCols + col]; }
+
+	/// Drops every baked chunk, e.g. when the renderer lost the content of its render targets
+	void InvalidateChunks();
+
+	/// <summary>
+	/// Draws the chunks overlapping the camera's view
+	/// </summary>
+	void Render(SDL_Renderer* renderer, const std::unique_ptr<AssetStore>& assetStore, const Camera& camera);
+
+	int GetNumCols() const { return numCols; }
+	int GetNumRows() const { return numRows; }
+	int GetNumBakedChunks() const { return numBakedChunks; }
+	/// Size of a tile in world pixels
+	double GetScaledTileSize() const { return tileSize * tileScale; }
+};
+
+#endif // !TILEMAP_H
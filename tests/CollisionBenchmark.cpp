@@ -0,0 +1,75 @@
+#include "Tests.h"
+#include "../npge2d/src/Systems/CollisionSystem.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+// Frame time of CollisionSystem::Update with each broad phase. 16px colliders in an 8000x8000 world
+// move up to 2px per frame, either spread over the world or packed in a few clusters
+
+namespace {
+	const float WORLD_SIZE = 8000.0f;
+	const float MAX_MOVE = 2.0f;
+	const int NUM_CLUSTERS = 8;
+	const float CLUSTER_SIZE = 800.0f;
+	const int NUM_FRAMES = 20;
+
+	double MeasureFrameTime(BroadPhase broadPhase, int numColliders, bool isClustered)
+	{
+		// Same seed for both broad phases, they see the same scene
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> worldPosition(0.0f, WORLD_SIZE);
+		std::uniform_real_distribution<float> clusterPosition(0.0f, CLUSTER_SIZE);
+		std::uniform_real_distribution<float> move(-MAX_MOVE, MAX_MOVE);
+
+		std::vector<glm::vec2> clusterOrigins;
+		for (int i = 0; i < NUM_CLUSTERS; i++) {
+			clusterOrigins.emplace_back(worldPosition(random) * 0.9f, worldPosition(random) * 0.9f);
+		}
+
+		Registry registry;
+		registry.AddSystem<CollisionSystem>(broadPhase);
+		CollisionSystem& collisionSystem = registry.GetSystem<CollisionSystem>();
+
+		std::vector<Entity> colliders;
+		for (int i = 0; i < numColliders; i++) {
+			const glm::vec2 position = isClustered
+				? clusterOrigins[i % NUM_CLUSTERS] + glm::vec2(clusterPosition(random), clusterPosition(random))
+				: glm::vec2(worldPosition(random), worldPosition(random));
+
+			Entity entity = registry.CreateEntity();
+			entity.AddComponent<TransformComponent>(position, glm::vec2(1, 1), 0.0);
+			entity.AddComponent<BoxColliderComponent>(16, 16);
+			colliders.push_back(entity);
+		}
+		registry.Update();
+		collisionSystem.Update();
+
+		double totalMilliseconds = 0.0;
+		for (int frame = 0; frame < NUM_FRAMES; frame++) {
+			for (auto entity : colliders) {
+				entity.GetComponent<TransformComponent>().position += glm::vec2(move(random), move(random));
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+			collisionSystem.Update();
+			totalMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+		return totalMilliseconds / NUM_FRAMES;
+	}
+}
+
+void BenchmarkBroadPhases()
+{
+	const int COLLIDER_COUNTS[] = { 10000, 50000 };
+
+	std::printf("%-18s %10s %10s\n", "", "grid", "sap");
+	for (int numColliders : COLLIDER_COUNTS) {
+		for (bool isClustered : { false, true }) {
+			const double gridTime = MeasureFrameTime(BroadPhase::SpatialHash, numColliders, isClustered);
+			const double sweepTime = MeasureFrameTime(BroadPhase::SweepAndPrune, numColliders, isClustered);
+			std::printf("%3dk %-13s %7.1f ms %7.1f ms\n", numColliders / 1000, isClustered ? "clustered" : "uniform", gridTime, sweepTime);
+		}
+	}
+}
@@ -0,0 +1,76 @@
+#include "Tests.h"
+#include "../npge2d/src/Systems/CollisionSystem.h"
+
+#include <algorithm>
+
+// Collision pairs and their begin / end events, with both broad phases
+
+namespace {
+	Entity CreateCollider(Registry& registry, glm::vec2 position)
+	{
+		Entity entity = registry.CreateEntity();
+		entity.AddComponent<TransformComponent>(position, glm::vec2(1, 1), 0.0);
+		entity.AddComponent<BoxColliderComponent>(16, 16);
+		return entity;
+	}
+
+	bool HasPair(const std::vector<CollisionPair>& pairs, Entity a, Entity b)
+	{
+		return std::any_of(pairs.begin(), pairs.end(), [a, b](const CollisionPair& pair) {
+			return (pair.a == a && pair.b == b) || (pair.a == b && pair.b == a);
+		});
+	}
+
+	bool CheckBroadPhase(BroadPhase broadPhase)
+	{
+		bool isPassing = true;
+
+		Registry registry;
+		registry.AddSystem<CollisionSystem>(broadPhase);
+		CollisionSystem& collisionSystem = registry.GetSystem<CollisionSystem>();
+
+		Entity a = CreateCollider(registry, glm::vec2(0, 0));
+		Entity b = CreateCollider(registry, glm::vec2(8, 8));
+		Entity apart = CreateCollider(registry, glm::vec2(500, 500));
+		registry.Update();
+		collisionSystem.Update();
+
+		TEST_CHECK(isPassing, collisionSystem.GetCollisions().size() == 1);
+		TEST_CHECK(isPassing, HasPair(collisionSystem.GetCollisionsBegan(), a, b));
+		TEST_CHECK(isPassing, collisionSystem.GetCollisionsEnded().empty());
+
+		// Still overlapping, nothing begins or ends
+		collisionSystem.Update();
+		TEST_CHECK(isPassing, collisionSystem.GetCollisionsBegan().empty());
+		TEST_CHECK(isPassing, collisionSystem.GetCollisionsEnded().empty());
+
+		// a dies while overlapping b and its id goes to a new entity overlapping b in the same place.
+		// The old pair ends and the new one begins, even though the ids are the same
+		a.Kill();
+		registry.Update();
+		Entity recycled = CreateCollider(registry, glm::vec2(0, 0));
+		TEST_CHECK(isPassing, recycled.GetId() == a.GetId());
+		registry.Update();
+		collisionSystem.Update();
+
+		TEST_CHECK(isPassing, HasPair(collisionSystem.GetCollisions(), recycled, b));
+		TEST_CHECK(isPassing, HasPair(collisionSystem.GetCollisionsEnded(), a, b));
+		TEST_CHECK(isPassing, HasPair(collisionSystem.GetCollisionsBegan(), recycled, b));
+
+		// Moving apart ends the pair
+		apart.GetComponent<TransformComponent>().position = glm::vec2(1000, 1000);
+		b.GetComponent<TransformComponent>().position = glm::vec2(500, 500);
+		collisionSystem.Update();
+		TEST_CHECK(isPassing, collisionSystem.GetCollisions().empty());
+		TEST_CHECK(isPassing, HasPair(collisionSystem.GetCollisionsEnded(), recycled, b));
+
+		return isPassing;
+	}
+}
+
+bool TestCollisionSystem()
+{
+	const bool isGridPassing = CheckBroadPhase(BroadPhase::SpatialHash);
+	const bool isSweepPassing = CheckBroadPhase(BroadPhase::SweepAndPrune);
+	return isGridPassing && isSweepPassing;
+}
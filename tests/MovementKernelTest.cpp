@@ -0,0 +1,61 @@
+#include "Tests.h"
+#include "../npge2d/src/Systems/MovementKernel.h"
+
+#include <cstring>
+#include <vector>
+
+// Checks the SIMD movement kernels against the scalar one.
+// Every path rounds the same way, so the results must match bit for bit
+
+namespace {
+	const std::size_t MAX_COUNT = 70;
+	// Packed pairs, TransformComponent (6 floats) and an odd stride
+	const std::size_t STRIDES[] = { 2, 3, 6 };
+	// Written between the pairs, a kernel must leave it untouched
+	const float GUARD = -12345.0f;
+
+	typedef void (*Kernel)(float*, std::size_t, const float*, std::size_t, std::size_t, float);
+
+	std::vector<float> MakePairs(std::size_t count, std::size_t stride, float seed)
+	{
+		// One extra pair so reading or writing past the last entity lands on the guard
+		std::vector<float> pairs((count + 1) * stride, GUARD);
+		for (std::size_t i = 0; i < count; i++) {
+			pairs[i * stride] = seed + 0.37f * i;
+			pairs[i * stride + 1] = seed * 0.5f - 1.13f * i;
+		}
+		return pairs;
+	}
+
+	bool CheckKernel(const char* name, Kernel kernel)
+	{
+		const float deltaTime = 1.0f / 60.0f;
+		bool isCorrect = true;
+
+		for (std::size_t positionStride : STRIDES) {
+			for (std::size_t velocityStride : STRIDES) {
+				for (std::size_t count = 0; count <= MAX_COUNT; count++) {
+					const std::vector<float> velocities = MakePairs(count, velocityStride, 30.5f);
+					std::vector<float> expected = MakePairs(count, positionStride, 100.25f);
+					std::vector<float> result = expected;
+
+					MovementKernel::IntegrateScalar(expected.data(), positionStride, velocities.data(), velocityStride, count, deltaTime);
+					kernel(result.data(), positionStride, velocities.data(), velocityStride, count, deltaTime);
+
+					if (std::memcmp(expected.data(), result.data(), expected.size() * sizeof(float)) != 0) {
+						std::printf("FAIL %s : count %zu position stride %zu velocity stride %zu\n", name, count, positionStride, velocityStride);
+						isCorrect = false;
+					}
+				}
+			}
+		}
+		return isCorrect;
+	}
+}
+
+bool TestMovementKernel()
+{
+	bool isCorrect = CheckKernel("SSE2", MovementKernel::IntegrateSSE2);
+	isCorrect = CheckKernel("Integrate", MovementKernel::Integrate) && isCorrect;
+	return isCorrect;
+}
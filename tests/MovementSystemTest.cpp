@@ -0,0 +1,88 @@
+#include "Tests.h"
+#include "../npge2d/src/Systems/MovementSystem.h"
+
+#include <vector>
+
+// MovementSystem runs the kernel on component arrays, in both storages. With pools the arrays are only
+// valid while the owned pools stay in the System's entity order, so entities join and leave it in between
+
+namespace {
+	const int NUM_ENTITIES = 10000;
+	const float DELTA_TIME = 0.5f;
+
+	glm::vec2 GetVelocity(int index)
+	{
+		return glm::vec2(0.25f * (index % 7), -1.5f * (index % 5));
+	}
+}
+
+bool TestMovementSystem()
+{
+	bool isPassing = true;
+
+	ThreadPool threadPool(4);
+	Registry registry;
+	registry.SetThreadPool(&threadPool);
+	registry.AddSystem<MovementSystem>();
+	MovementSystem& movementSystem = registry.GetSystem<MovementSystem>();
+
+	// Every third entity has no RigidBody, so the pools start out in different orders
+	std::vector<Entity> entities;
+	for (int i = 0; i < NUM_ENTITIES; i++) {
+		Entity entity = registry.CreateEntity();
+		entity.AddComponent<TransformComponent>(glm::vec2(i, 2 * i), glm::vec2(1, 1), 0.0);
+		if (i % 3 != 0) {
+			entity.AddComponent<RigidBodyComponent>(GetVelocity(i));
+		}
+		entities.push_back(entity);
+	}
+	registry.Update();
+
+	// Join, leave and die while in the System
+	for (int i = 0; i < NUM_ENTITIES; i += 10) {
+		if (i % 3 == 0) {
+			entities[i].AddComponent<RigidBodyComponent>(GetVelocity(i));
+		}
+		else {
+			entities[i].RemoveComponent<RigidBodyComponent>();
+		}
+	}
+	for (int i = 7; i < NUM_ENTITIES; i += 50) {
+		entities[i].Kill();
+	}
+	registry.Update();
+
+#ifndef NPGE_ECS_ARCHETYPE_STORAGE
+	const Span<Entity> systemEntities = movementSystem.GetSystemEntities();
+	const auto& transformIds = registry.GetComponentPool<TransformComponent>()->GetEntityIds();
+	const auto& rigidBodyIds = registry.GetComponentPool<RigidBodyComponent>()->GetEntityIds();
+	bool isInEntityOrder = true;
+	for (int i = 0; i < static_cast<int>(systemEntities.size()); i++) {
+		isInEntityOrder = isInEntityOrder && transformIds[i] == systemEntities[i].GetId() && rigidBodyIds[i] == systemEntities[i].GetId();
+	}
+	TEST_CHECK(isPassing, isInEntityOrder);
+#endif
+
+	movementSystem.Update(DELTA_TIME);
+	movementSystem.Update(DELTA_TIME);
+
+	// Same float operations as the kernel, the positions must match exactly
+	bool isMovedCorrectly = true;
+	for (int i = 0; i < NUM_ENTITIES; i++) {
+		if (!entities[i].IsAlive()) {
+			continue;
+		}
+
+		glm::vec2 expected(i, 2 * i);
+		if (entities[i].HasComponent<RigidBodyComponent>()) {
+			for (int step = 0; step < 2; step++) {
+				expected.x += GetVelocity(i).x * DELTA_TIME;
+				expected.y += GetVelocity(i).y * DELTA_TIME;
+			}
+		}
+		isMovedCorrectly = isMovedCorrectly && entities[i].GetComponent<TransformComponent>().position == expected;
+	}
+	TEST_CHECK(isPassing, isMovedCorrectly);
+
+	return isPassing;
+}
@@ -0,0 +1,37 @@
+#include "Tests.h"
+#include "../npge2d/src/ECS/ECS.h"
+
+// Entity bookkeeping of the Registry
+
+bool TestRegistry()
+{
+	bool isPassing = true;
+
+	Registry registry;
+	Entity a = registry.CreateEntity();
+	Entity b = registry.CreateEntity();
+	registry.CreateEntity();
+	TEST_CHECK(isPassing, registry.GetNumLiveEntities() == 3);
+
+	// A kill counts right away, killing twice counts once
+	a.Kill();
+	a.Kill();
+	TEST_CHECK(isPassing, registry.GetNumLiveEntities() == 2);
+
+	registry.Update();
+	TEST_CHECK(isPassing, registry.GetNumLiveEntities() == 2);
+	TEST_CHECK(isPassing, !a.IsAlive());
+
+	// The freed id is reused, and can be killed again under its new generation
+	Entity recycled = registry.CreateEntity();
+	TEST_CHECK(isPassing, recycled.GetId() == a.GetId());
+	recycled.Kill();
+	b.Kill();
+	TEST_CHECK(isPassing, registry.GetNumLiveEntities() == 1);
+
+	registry.Update();
+	TEST_CHECK(isPassing, registry.GetNumLiveEntities() == 1);
+	TEST_CHECK(isPassing, !recycled.IsAlive() && !b.IsAlive());
+
+	return isPassing;
+}
@@ -0,0 +1,79 @@
+#include "Tests.h"
+#include "../npge2d/src/Systems/RenderSystem.h"
+
+#include <algorithm>
+
+// Culling and draw order of RenderSystem, checked through GetVisibleEntities without a renderer
+
+namespace {
+	Entity CreateSprite(Registry& registry, glm::vec2 position, int zIndex)
+	{
+		Entity entity = registry.CreateEntity();
+		entity.AddComponent<TransformComponent>(position, glm::vec2(1, 1), 0.0);
+		entity.AddComponent<SpriteComponent>("test-sprite", 16, 16, zIndex);
+		return entity;
+	}
+
+	bool IsVisible(RenderSystem& renderSystem, const Camera& camera, Entity entity)
+	{
+		const std::vector<Entity> visibleEntities = renderSystem.GetVisibleEntities(camera);
+		return std::find(visibleEntities.begin(), visibleEntities.end(), entity) != visibleEntities.end();
+	}
+}
+
+bool TestRenderSystem()
+{
+	bool isPassing = true;
+
+	Registry registry;
+	registry.AddSystem<RenderSystem>();
+	RenderSystem& renderSystem = registry.GetSystem<RenderSystem>();
+
+	const Camera origin(glm::vec2(0, 0), 1.0f, 200, 200);
+	const Camera farAway(glm::vec2(5000, 5000), 1.0f, 200, 200);
+
+	// Lowest zIndex first, insertion order inside a zIndex, off screen sprites are culled
+	Entity top = CreateSprite(registry, glm::vec2(10, 10), 2);
+	Entity first = CreateSprite(registry, glm::vec2(20, 10), 1);
+	Entity second = CreateSprite(registry, glm::vec2(30, 10), 1);
+	Entity hidden = CreateSprite(registry, glm::vec2(5050, 5050), 0);
+	registry.Update();
+
+	std::vector<Entity> visibleEntities = renderSystem.GetVisibleEntities(origin);
+	TEST_CHECK(isPassing, (visibleEntities == std::vector<Entity>{ first, second, top }));
+
+	// A zIndex change moves the sprite before it is drawn, even one changed while off screen
+	second.GetComponent<SpriteComponent>().zIndex = 0;
+	hidden.GetComponent<SpriteComponent>().zIndex = 3;
+	visibleEntities = renderSystem.GetVisibleEntities(origin);
+	TEST_CHECK(isPassing, (visibleEntities == std::vector<Entity>{ second, first, top }));
+
+	hidden.GetComponent<TransformComponent>().position = glm::vec2(40, 10);
+	renderSystem.RefreshBounds(hidden);
+	visibleEntities = renderSystem.GetVisibleEntities(origin);
+	TEST_CHECK(isPassing, (visibleEntities == std::vector<Entity>{ second, first, top, hidden }));
+
+	// A RigidBody added after the sprite joined makes it follow its transform
+	Entity late = CreateSprite(registry, glm::vec2(50, 50), 0);
+	registry.Update();
+	TEST_CHECK(isPassing, IsVisible(renderSystem, origin, late));
+
+	late.AddComponent<RigidBodyComponent>(glm::vec2(10, 0));
+	late.GetComponent<TransformComponent>().position = glm::vec2(5100, 5100);
+	TEST_CHECK(isPassing, !IsVisible(renderSystem, origin, late));
+	TEST_CHECK(isPassing, IsVisible(renderSystem, farAway, late));
+
+	// Without its RigidBody it stays binned where it stopped
+	late.RemoveComponent<RigidBodyComponent>();
+	late.GetComponent<TransformComponent>().position = glm::vec2(60, 60);
+	TEST_CHECK(isPassing, IsVisible(renderSystem, farAway, late));
+	TEST_CHECK(isPassing, !IsVisible(renderSystem, origin, late));
+
+	// Killed sprites leave the layers and the grid
+	top.Kill();
+	registry.Update();
+	visibleEntities = renderSystem.GetVisibleEntities(origin);
+	TEST_CHECK(isPassing, (visibleEntities == std::vector<Entity>{ second, first, hidden }));
+
+	return isPassing;
+}
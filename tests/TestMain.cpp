@@ -0,0 +1,39 @@
+#include "Tests.h"
+
+#include <cstring>
+
+// Runs every test, returns non zero if one of them failed so the post build step fails.
+// With --bench it prints the benchmarks instead
+
+namespace {
+	struct Test {
+		const char* name;
+		bool (*run)();
+	};
+
+	const Test TESTS[] = {
+		{ "CollisionSystem", TestCollisionSystem },
+		{ "MovementKernel", TestMovementKernel },
+		{ "MovementSystem", TestMovementSystem },
+		{ "Registry", TestRegistry },
+		{ "RenderSystem", TestRenderSystem },
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+		BenchmarkBroadPhases();
+		return 0;
+	}
+
+	int numFailed = 0;
+	for (const auto& test : TESTS) {
+		const bool isPassing = test.run();
+		std::printf("%s %s\n", isPassing ? "PASS" : "FAIL", test.name);
+		numFailed += isPassing ? 0 : 1;
+	}
+
+	std::printf(numFailed == 0 ? "All tests passed\n" : "%d tests failed\n", numFailed);
+	return numFailed == 0 ? 0 : 1;
+}
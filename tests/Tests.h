@@ -0,0 +1,19 @@
+#ifndef TESTS_H
+#define TESTS_H
+
+#include <cstdio>
+
+// Every test prints the checks that failed and returns false if there was one
+
+#define TEST_CHECK(isPassing, condition) if (!(condition)) { std::printf("FAIL %s:%d : %s\n", __FILE__, __LINE__, #condition); isPassing = false; }
+
+bool TestCollisionSystem();
+bool TestMovementKernel();
+bool TestMovementSystem();
+bool TestRegistry();
+bool TestRenderSystem();
+
+// Timings printed by the runner when it is started with --bench
+void BenchmarkBroadPhases();
+
+#endif // !TESTS_H